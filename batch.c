@@ -0,0 +1,339 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Batch printing.  'ssv -b' prints a list of datafiles
+ **                     (by default the sec_A..sec_P set written by section)
+ **                     in one run, one xwd file per datafile, spreading the
+ **                     work over a pool of worker processes.  The fonts and
+ **                     base bitmaps are compiled into the program, so the
+ **                     workers share them without loading anything; each
+ **                     worker has its own copy of the subsector globals, so
+ **                     load_sector_file() and gen_sector() run unchanged.
+ **
+ **  File:              batch.c, containing the following subroutines:
+ **                       batch_print()
+ **                       batch_output_name()
+ **                       batch_split()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define  NUM_SSECS  16
+
+static char *ssec_name[NUM_SSECS] = { "sec_A", "sec_B", "sec_C", "sec_D",
+				      "sec_E", "sec_F", "sec_G", "sec_H",
+				      "sec_I", "sec_J", "sec_K", "sec_L",
+				      "sec_M", "sec_N", "sec_O", "sec_P" };
+
+/*-- the output for datafile 'name' is written next to it as 'name.xwd' (or
+     'name.pbm', see raster_extension) --*/
+char *batch_output_name(name, buf, size)
+char *name, *buf;
+int size;
+{
+  if (strlen(name) + 5 > size)
+    return (NULL);
+  sprintf(buf, "%s%s", name, raster_extension());
+  return (buf);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  run_workers                                                     *
+ *                                                                           *
+ * Purpose:  Run worker(first, njobs) for first = 0..njobs-1, each in its    *
+ *           own process (or all in this one if njobs is 1).  Each worker    *
+ *           takes every njobs'th item starting at 'first', so they finish   *
+ *           at about the same time.  Returns the total of the failure       *
+ *           counts the workers return.                                      *
+ *                                                                           *
+ *****************************************************************************/
+
+static int run_workers(worker, nitems, njobs)
+int (*worker)();
+int nitems, njobs;
+{
+  int i, status, failed = 0, started = 0;
+  pid_t pid;
+
+  if (njobs <= 0)
+    njobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (njobs > nitems)
+    njobs = nitems;
+  if (njobs <= 1)
+    return ((*worker)(0, 1));
+
+  fflush(stdout);
+  fflush(stderr);
+  for (i=0; i<njobs; i++) {
+    pid = fork();
+    if (pid == 0) {
+      status = (*worker)(i, njobs);
+      _exit((status > 255) ? 255 : status);
+     }
+    if (pid < 0) {
+/*--- out of processes: whatever is left is done right here ---*/
+      failed += (*worker)(i, njobs);
+      continue;
+     }
+    started++;
+   }
+  while (started > 0) {
+    if (wait(&status) < 0)
+      break;
+    if (!WIFEXITED(status))
+      failed++;
+    else
+      failed += WEXITSTATUS(status);
+    started--;
+   }
+  return (failed);
+}
+
+static char **batch_files;
+static int batch_nfiles;
+
+/*-- print every njobs'th file starting at 'first'; returns the failures --*/
+static int batch_worker(first, njobs)
+int first, njobs;
+{
+  char out_name[1024];
+  int i, failed = 0;
+
+  for (i=first; i<batch_nfiles; i+=njobs) {
+    if (!load_sector_file(batch_files[i])) {
+      fprintf(stderr, "%s: Invalid datafile \"%s\"\n", program_name,
+                batch_files[i]);
+      failed++;
+      continue;
+     }
+    if ((batch_output_name(batch_files[i], out_name, sizeof(out_name)) == NULL)
+        || !raster_print_subsector(out_name)) {
+      fprintf(stderr, "%s: Cannot write output for \"%s\"\n", program_name,
+                batch_files[i]);
+      failed++;
+     }
+   }
+  return (failed);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  batch_print                                                     *
+ *                                                                           *
+ * Purpose:  Print 'nfiles' datafiles (sec_A..sec_P if there are none) with  *
+ *           'njobs' worker processes, or one per online processor if njobs  *
+ *           is 0.  Returns the number of files that failed.                 *
+ *                                                                           *
+ *****************************************************************************/
+
+int batch_print(nfiles, files, njobs)
+int nfiles, njobs;
+char **files;
+{
+  if (nfiles == 0) {
+    files = ssec_name;
+    nfiles = NUM_SSECS;
+   }
+  batch_files = files;
+  batch_nfiles = nfiles;
+  return (run_workers(batch_worker, nfiles, njobs));
+}
+
+/*****************************************************************************
+ **
+ **  The fused split-and-print pipeline.  The whole sector file is mapped
+ **  into memory once (open_text); every world line is dealt to its subsector's bucket with
+ **  section's target = ((row-1)/10)*4 + (col-1)/8, and the workers feed
+ **  each bucket straight to parse_sector_line() and the raster device.
+ **  The sec_X datafiles section would have written are only written if
+ **  asked for.
+ **
+ *****************************************************************************/
+
+static char *header[8] = {
+    "#",
+    "# Trade routes within the subsector",
+    "#src. dst.  X Y dst. offsets",
+    "# $1840 1841  0 1",
+    "#",
+    "#--------1---------2---------3---------4---------5---------6---------7",
+    "#PlanetName   Loc. UPP Code   B   Notes         Z  PBG Al. Star(s)",
+    "#----------   ---- ---------  - --------------- -  --- -- ---------" };
+
+static char *split_name;              /* the sector file, for the titles */
+static char *split_text, *split_end;  /* its contents                     */
+static int *split_first, *split_line; /* line offsets per subsector       */
+static int split_write;
+static int split_head = -1;           /* offset of a tab header line      */
+
+/*-- the length of the line at 'p', up to and including its newline --*/
+static int line_length(p, end)
+char *p, *end;
+{
+  char *nl;
+
+  if ((nl = memchr(p, '\n', end - p)) == NULL)
+    return (end - p);
+  return (nl - p + 1);
+}
+
+static int split_worker(first, njobs)
+int first, njobs;
+{
+  char out_name[16], line[128], *p;
+  int t, i, j, k, len, failed = 0;
+  FILE *fd;
+
+  for (t=first; t<NUM_SSECS; t+=njobs) {
+    w_cnt = tr_cnt = bdr_cnt = private_bdr_cnt = 0;
+    hex_index_stale();
+    label_stale();
+/*--- cut to fit title[], as parse_sector_line() cuts an '@' line ---*/
+    snprintf(line, sizeof(line), "SUB-SECTOR: %s   SECTOR: %s", ssec_name[t],
+                split_name);
+    k = (strlen(line) < 78) ? strlen(line) : 78;
+    memcpy(title, line, k);
+    title[k] = '\n';
+    title[k+1] = '\0';
+    fd = NULL;
+    if (split_write) {
+      if ((fd = fopen(ssec_name[t], "w")) == NULL) {
+        fprintf(stderr, "%s: Cannot open %s for output\n", program_name,
+                ssec_name[t]);
+        failed++;
+       }
+      else {
+        fprintf(fd, "@%s", title);
+        for (j=0; j<8; j++)
+          fprintf(fd, "%s\n", header[j]);
+        if (split_head >= 0)
+          fwrite(split_text + split_head, line_length(split_text + split_head,
+                split_end), 1, fd);
+       }
+     }
+    for (i=split_first[t]; i<split_first[t+1]; i++) {
+      p = split_text + split_line[i];
+      len = line_length(p, split_end);
+      if (fd != NULL)
+        fwrite(p, len, 1, fd);
+      parse_sector_line(p, len, 0, 0);
+     }
+    if (claim_radius >= 0)
+      border_claims(NULL, claim_radius);
+    if ((fd != NULL) && (fclose(fd) != 0))
+      failed++;
+    sprintf(out_name, "%s%s", ssec_name[t], raster_extension());
+    if (!raster_print_subsector(out_name)) {
+      fprintf(stderr, "%s: Cannot write \"%s\"\n", program_name, out_name);
+      failed++;
+     }
+   }
+  return (failed);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  batch_split                                                     *
+ *                                                                           *
+ * Purpose:  Print all 16 subsectors of the GEnie format sector file 'name'  *
+ *           to sec_A.xwd..sec_P.xwd in one pass over the file, writing the  *
+ *           sec_A..sec_P datafiles as well if 'write_files' is set.  Lines  *
+ *           whose hex is not in 0101..3240 are skipped.  A tab delimited    *
+ *           file is dealt out by its Hex column, and its header line,       *
+ *           which the workers inherit, starts each datafile written.        *
+ *           Returns the number of subsectors that failed, or -1 if the file *
+ *           cannot be read.                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+int batch_split(name, njobs, write_files)
+char *name;
+int njobs, write_files;
+{
+  int i, k, n, len, col, row, target, failed, count[NUM_SSECS+1];
+  char *p, *end;
+  TextFile tf;
+
+  if (!open_text(name, &tf)) {
+    fprintf(stderr, "%s: Cannot open %s for input\n", program_name, name);
+    return (-1); }
+  split_text = tf.text;
+  end = split_text + tf.size;
+
+/*--- count the lines for each subsector, then fill in their offsets ---*/
+  tab_reset();
+  split_head = -1;
+  for (n=0; n<2; n++) {
+    memset((char *) count, 0, sizeof(count));
+    for (p=split_text; p<end; p+=len) {
+      len = line_length(p, end);
+      k = ((len > 0) && (p[len-1] == '\n')) ? len - 1 : len;
+      if ((k > 0) && (p[k-1] == '\r'))
+        k--;
+      if ((p[0] != '#') && (p[0] != '@') && (p[0] != '$') && (p[0] != '^') &&
+          (memchr(p, '\t', k) != NULL)) {
+        if (!tab_hex(p, k, &col, &row)) {
+          if (tab_header(p, k))
+            split_head = p - split_text;
+          continue;
+         }
+       }
+      else {
+        if (len < 18) continue;
+        for (i=14; i<18; i++)
+          if ((p[i] < '0') || (p[i] > '9')) break;
+        if (i < 18) continue;
+        col = (p[14] - '0') * 10 + (p[15] - '0');
+        row = (p[16] - '0') * 10 + (p[17] - '0');
+       }
+      if ((col < 1) || (col > SECTOR_COLS) || (row < 1) || (row > SECTOR_ROWS))
+        continue;
+      target = (((row-1)/10)*4) + ((col-1)/8);
+      if (n == 0)
+        count[target+1]++;
+      else
+        split_line[split_first[target] + count[target]++] = p - split_text;
+     }
+    if (n == 0) {
+      if ((split_first = (int *) malloc((NUM_SSECS+1) * sizeof(int))) == NULL) {
+        fprintf(stderr, "%s: Cannot split %s: out of memory\n", program_name,
+                name);
+        close_text(&tf);
+        return (-1); }
+      split_first[0] = 0;
+      for (i=0; i<NUM_SSECS; i++)
+        split_first[i+1] = split_first[i] + count[i+1];
+      split_line = (int *) malloc((split_first[NUM_SSECS] + 1) * sizeof(int));
+      if (split_line == NULL) {
+        fprintf(stderr, "%s: Cannot split %s: out of memory\n", program_name,
+                name);
+        free((char *) split_first);
+        close_text(&tf);
+        return (-1); }
+     }
+   }
+  split_name = name;
+  split_end = end;
+  split_write = write_files;
+  failed = run_workers(split_worker, NUM_SSECS, njobs);
+  close_text(&tf);
+  free((char *) split_first);
+  free((char *) split_line);
+  return (failed);
+}
@@ -0,0 +1,357 @@
+/******************************************************************************
+ **  Program:           ssv_bench
+ **
+ **  Description:       Benchmark driver for 'make bench'.  Times the three
+ **                     phases of printing a subsector on their own --
+ **                     load_sector_file(), gen_sector() and the whole of
+ **                     raster_print_subsector() -- over a fixed corpus:
+ **                     the sec_J sample, a dense sector with every one of
+ **                     its 1280 hexes filled, and a stress subsector with
+ **                     thousands of routes and border edges.  The last two
+ **                     are generated from a fixed seed, so every run sees
+ **                     the same files.  If a display can be opened the X
+ **                     Device is timed too, drawing into a pixmap.  The
+ **                     datafile cache is not used, so the load is always
+ **                     the parse.
+ **
+ **                     Each phase is repeated until it has run for at least
+ **                     the minimum time, and one line of JSON is printed
+ **                     for it: the number of iterations, the mean and best
+ **                     wall time, the allocations made by ssv's own code
+ **                     (malloc, calloc and realloc are wrapped at link time)
+ **                     and the X requests, each per iteration.
+ **
+ **  File:              bench.c, containing the following subroutines:
+ **                       main()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <time.h>
+#include <sys/stat.h>
+
+#define  DATA_DIR     "bench_data"
+#define  DENSE_FILE   DATA_DIR "/dense.sec"
+#define  STRESS_FILE  DATA_DIR "/stress"
+#define  OUT_FILE     DATA_DIR "/bench.xwd"
+
+#define  MIN_ITERS    5
+#define  NUM_ROUTES   4000
+
+#define  PHASE_LOAD      0
+#define  PHASE_GEN       1
+#define  PHASE_PRINT     2
+#define  PHASE_X_GEN     3
+#define  PHASE_X_LAYERS  4
+#define  NUM_PHASES      5
+
+static char *phase_name[NUM_PHASES] = { "load_sector_file", "gen_sector",
+        "print_subsector", "x_gen_sector", "x_layer_show" };
+
+/*****************************************************************************
+ **
+ **  Allocation counting.  The driver is linked with -Wl,--wrap for the
+ **  three allocators, so every call ssv's modules make comes through here.
+ **  Allocations made inside libc or Xlib are not seen.
+ **
+ *****************************************************************************/
+
+extern void *__real_malloc(), *__real_calloc(), *__real_realloc();
+
+static unsigned long alloc_cnt, alloc_bytes;
+
+void *__wrap_malloc(size)
+size_t size;
+{
+  alloc_cnt++;
+  alloc_bytes += size;
+  return (__real_malloc(size));
+}
+
+void *__wrap_calloc(n, size)
+size_t n, size;
+{
+  alloc_cnt++;
+  alloc_bytes += n * size;
+  return (__real_calloc(n, size));
+}
+
+void *__wrap_realloc(p, size)
+void *p;
+size_t size;
+{
+  alloc_cnt++;
+  alloc_bytes += size;
+  return (__real_realloc(p, size));
+}
+
+/*-- a fixed pseudo-random sequence (the ANSI C example rand()) --*/
+static unsigned long seed;
+
+static int next_rand(n)
+int n;
+{
+  seed = seed * 1103515245 + 12345;
+  return ((int) ((seed / 65536) % 32768) % n);
+}
+
+static char *syllable[16] = { "an", "bel", "cor", "dra", "en", "fal", "gar",
+        "hu", "is", "jen", "ka", "lor", "mir", "nu", "os", "pra" };
+static char *trade[8] = { "Ag", "Ri", "Ni", "In", "Hi", "Lo", "Po", "De" };
+static char ports[] = "AABBCCDEX";
+static char bases[] = "ABCDHMNRSTWZ  ";
+static char zones[] = "  AR";
+static char ehex[] = "0123456789ABCDEF";
+
+/*-- one world line for hex col,row (from 1), in the column layout of sec_J --*/
+static void write_world(fd, col, row)
+FILE *fd;
+int col, row;
+{
+  char name[16], notes[16], hex[5];
+  int i, n;
+
+  name[0] = '\0';
+  for (i=next_rand(4)+1; i>0; i--)
+    strcat(name, syllable[next_rand(16)]);
+  name[0] -= 'a' - 'A';
+  name[12] = '\0';
+  notes[0] = '\0';
+  for (i=next_rand(6); i>0; i--) {
+    if (notes[0] != '\0') strcat(notes, " ");
+    strcat(notes, trade[next_rand(8)]);
+   }
+  sprintf(hex, "%02d%02d", col, row);
+  n = next_rand(11);
+  fprintf(fd, "%-13s %s %c%c%c%c%c%c%c-%c  %c %-15s %c  %d%d%d %-2s G2 V\n",
+        name, hex, ports[next_rand(9)], ehex[n], ehex[next_rand(11)],
+        ehex[next_rand(11)], ehex[next_rand(16)], ehex[next_rand(16)],
+        ehex[next_rand(16)], ehex[next_rand(16)], bases[next_rand(14)],
+        notes, zones[next_rand(4)], next_rand(10), next_rand(4),
+        next_rand(5), (next_rand(2) == 0) ? "Im" : "Sw");
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  make_corpus                                                     *
+ *                                                                           *
+ * Purpose:  Write the generated datafiles into DATA_DIR: a sector file with *
+ *           a world in every hex, and a subsector with a world in every hex,*
+ *           NUM_ROUTES routes of up to 4 hexes and every edge of every hex  *
+ *           marked as a border.  Returns FALSE if they cannot be written.   *
+ *                                                                           *
+ *****************************************************************************/
+
+static int make_corpus()
+{
+  FILE *fd;
+  int col, row, i, e, dc, dr;
+
+  (void) mkdir(DATA_DIR, 0777);
+
+  seed = 1990;
+  if ((fd = fopen(DENSE_FILE, "w")) == NULL)
+    return (FALSE);
+  for (col=1; col<=SECTOR_COLS; col++)
+    for (row=1; row<=SECTOR_ROWS; row++)
+      write_world(fd, col, row);
+  if (fclose(fd) != 0)
+    return (FALSE);
+
+  if ((fd = fopen(STRESS_FILE, "w")) == NULL)
+    return (FALSE);
+  fprintf(fd, "@SUB-SECTOR: Stress   SECTOR: Benchmark\n");
+  for (i=0; i<NUM_ROUTES; i++) {
+    col = next_rand(8) + 1;
+    row = next_rand(10) + 1;
+    dc = next_rand(9) - 4;
+    dr = next_rand(9) - 4;
+    fprintf(fd, "$%02d%02d %02d%02d %2d%2d\n", col, row,
+        ((col + dc + 7) % 8) + 1, ((row + dr + 9) % 10) + 1,
+        (col + dc < 1) ? -1 : (col + dc > 8) ? 1 : 0,
+        (row + dr < 1) ? -1 : (row + dr > 10) ? 1 : 0);
+   }
+  for (col=1; col<=8; col++)
+    for (row=1; row<=10; row++)
+      for (e=0; e<6; e++)
+        fprintf(fd, "^%02d%02d %d\n", col, row, e);
+  for (col=1; col<=8; col++)
+    for (row=1; row<=10; row++)
+      write_world(fd, col, row);
+  return (fclose(fd) == 0);
+}
+
+/*****************************************************************************
+ **
+ **  The phases.  Each run_phase() call does one iteration; the datafile
+ **  is loaded before a drawing phase is timed.
+ **
+ *****************************************************************************/
+
+static Device *gen_dev;
+static Pixmap bench_pix;
+
+static double now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int run_phase(phase, name)
+int phase;
+char *name;
+{
+  Device *dev;
+
+  switch (phase) {
+    case PHASE_LOAD     : return (load_sector_file(name));
+    case PHASE_GEN      : (*gen_dev->fill_rect)(gen_dev, PAPER, 0, 0,
+                                MAP_WIDTH, MAP_HEIGHT);
+                          gen_sector(gen_dev);
+                          return (TRUE);
+    case PHASE_PRINT    : return (raster_print_subsector(OUT_FILE));
+    case PHASE_X_GEN    : dev = x_device(bench_pix);
+                          (*dev->fill_rect)(dev, PAPER, 0, 0,
+                                MAP_WIDTH, MAP_HEIGHT);
+                          gen_sector(dev);
+                          XSync(dpy, FALSE);
+                          return (TRUE);
+    case PHASE_X_LAYERS : layer_invalidate(LAYER_GRID);
+                          layer_show(bench_pix, WORLD_ALLEGIANCE |
+                                WORLD_TRADE | WORLD_UWP);
+                          XSync(dpy, FALSE);
+                          return (TRUE);
+   }
+  return (FALSE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  time_phase                                                      *
+ *                                                                           *
+ * Purpose:  Run one phase on datafile 'name' until it has taken 'min_time'  *
+ *           seconds and MIN_ITERS iterations, after one untimed run to warm *
+ *           the caches, and print its JSON line.                            *
+ *           Returns FALSE if the phase failed.                              *
+ *                                                                           *
+ *****************************************************************************/
+
+static int time_phase(phase, name, min_time)
+int phase;
+char *name;
+double min_time;
+{
+  double start, t, total = 0.0, best = -1.0;
+  unsigned long allocs, bytes, requests = 0;
+  long iters = 0;
+
+  if (!run_phase(phase, name))
+    return (FALSE);
+  allocs = alloc_cnt;
+  bytes = alloc_bytes;
+  if (dpy != NULL)
+    requests = NextRequest(dpy);
+  while ((iters < MIN_ITERS) || (total < min_time)) {
+    start = now();
+    if (!run_phase(phase, name))
+      return (FALSE);
+    t = now() - start;
+    total += t;
+    if ((best < 0.0) || (t < best))
+      best = t;
+    iters++;
+   }
+  if (dpy != NULL)
+    requests = NextRequest(dpy) - requests;
+  printf("{\"corpus\": \"%s\", \"phase\": \"%s\", \"iterations\": %ld, ",
+        name, phase_name[phase], iters);
+  printf("\"wall_us_mean\": %.1f, \"wall_us_min\": %.1f, ",
+        total / iters * 1e6, best * 1e6);
+  printf("\"allocs\": %.1f, \"alloc_bytes\": %.1f, \"x_requests\": %.1f}\n",
+        (double) (alloc_cnt - allocs) / iters,
+        (double) (alloc_bytes - bytes) / iters, (double) requests / iters);
+  fflush(stdout);
+  return (TRUE);
+}
+
+static void usage()
+{
+  fprintf(stderr, "Usage: %s [-t seconds] [datafile ...]\n", program_name);
+  exit(1);
+}
+
+int main(argc, argv)
+int argc;
+char *argv[];
+{
+  static char *corpus[3] = { "sec_J", DENSE_FILE, STRESS_FILE };
+  char **files, *display;
+  double min_time = 0.5;
+  int i, phase, nfiles, failed = 0;
+
+  strcpy(program_name, "ssv_bench");
+  set_scale(1.0);
+/*--- load_sector_file() is timed parsing, not loading its cache ---*/
+  cache_enabled = FALSE;
+  for (i=1; (i < argc) && (argv[i][0] == '-'); i++) {
+    if ((strcmp(argv[i], "-t") != 0) || (++i >= argc))
+      usage();
+    min_time = atof(argv[i]);
+   }
+  files = &argv[i];
+  nfiles = argc - i;
+  if (nfiles == 0) {
+    if (!make_corpus()) {
+      fprintf(stderr, "%s: Cannot write the corpus in %s\n", program_name,
+                DATA_DIR);
+      exit(1); }
+    files = corpus;
+    nfiles = 3;
+   }
+
+  if ((gen_dev = raster_device(MAP_WIDTH, MAP_HEIGHT)) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", program_name);
+    exit(1); }
+  if ((dpy = XOpenDisplay(NULL)) != NULL) {
+    ScrDepth = XDefaultDepth(dpy, DefaultScreen(dpy));
+    win = DefaultRootWindow(dpy);
+    if (!x_setup(win))
+      exit(1);
+    bench_pix = XCreatePixmap(dpy, win, MAP_WIDTH, MAP_HEIGHT, ScrDepth);
+   }
+  else {
+    display = XDisplayName(NULL);
+    fprintf(stderr, "%s: Cannot open %s, X phases skipped\n", program_name,
+                display[0] ? display : "a display (DISPLAY is not set)");
+   }
+
+  for (i=0; i<nfiles; i++)
+    for (phase=0; phase<NUM_PHASES; phase++) {
+      if ((phase >= PHASE_X_GEN) && (dpy == NULL))
+        break;
+      if (phase != PHASE_LOAD)
+        (void) run_phase(PHASE_LOAD, files[i]);
+      if (!time_phase(phase, files[i], min_time)) {
+        fprintf(stderr, "%s: %s failed on \"%s\"\n", program_name,
+                phase_name[phase], files[i]);
+        failed++;
+        break;
+       }
+     }
+  raster_free(gen_dev);
+  exit(failed ? 1 : 0);
+}
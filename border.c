@@ -0,0 +1,445 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       The border edges read from the datafile.  A shared
+ **                     edge is often listed from both of the hexes it
+ **                     divides ('^0921 4' and '^0821 1'), so each edge is
+ **                     put in one canonical form, as edge 0, 1 or 2 of one
+ **                     of its two hexes, and kept only once.  For drawing,
+ **                     the edges that meet end to end are chained into
+ **                     polylines, so a border goes out as a few XDrawLines
+ **                     requests with proper joins rather than one segment
+ **                     per hex side.  With '-a radius' the borders of
+ **                     the polities are also worked out from the world
+ **                     allegiances (border_claims()).
+ **
+ **  File:              border.c, containing the following subroutines:
+ **                       border_stale()
+ **                       border_add()
+ **                       border_lines()
+ **                       border_claims()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+XPoint *file_bdr_pts;           /* the polylines, CoordModeOrigin    */
+BdrLine *file_bdr_line;
+int claim_radius = -1;          /* '-a': hexes a world claims, or -1 */
+
+static int bdr_max, seg_max, pts_max, line_max;
+static int line_cnt, lines_valid = FALSE;
+
+/*-- the edges kept, hashed on their canonical form; hash_cnt is how many
+     went in, so a reset of private_bdr_cnt shows as hash_cnt too big --*/
+static int *edge_slot, edge_max, hash_cnt;
+static unsigned edge_mask;
+
+#define EDGE_KEY(c, r, e)  ((((unsigned) (c) & 0x3fff) << 17) | \
+                            (((unsigned) (r) & 0x3fff) << 3) | (unsigned) (e))
+#define EDGE_HASH(k)       (((k) * 2654435761u) >> 7)
+
+/*****************************************************************************
+ **
+ **  Odd columns are half a hex lower than even ones, so the hex across an
+ **  edge depends on the column.  Edge e (0 at the top, clockwise) of a hex
+ **  is edge (e+3)%6 of the hex across it; edges 3, 4 and 5 are put in the
+ **  form of edges 0, 1 and 2 of that hex.
+ **
+ *****************************************************************************/
+
+static int across_col[6] = { 0, 1, 1, 0, -1, -1 };
+static int across_row[2][6] = { { -1, -1, 0, 1, 0, -1 },     /* even column */
+                                { -1, 0, 1, 1, 1, 0 } };     /* odd column  */
+
+static void canonical(c, r, e)
+int *c, *r, *e;
+{
+  if (*e < 3)
+    return;
+  *r += across_row[*c & 1][*e];
+  *c += across_col[*e];
+  *e -= 3;
+}
+
+static unsigned edge_key(b)
+Border *b;
+{
+  int c = b->col, r = b->row, e = b->edge;
+
+  canonical(&c, &r, &e);
+  return (EDGE_KEY(c, r, e));
+}
+
+/*-- the slot of 'key': the one holding its edge, or the empty one it
+     would go in --*/
+static unsigned edge_slot_of(key)
+unsigned key;
+{
+  unsigned i;
+
+  for (i=EDGE_HASH(key) & edge_mask; edge_slot[i] >= 0; i=(i+1) & edge_mask)
+    if (edge_key(&file_bdr[edge_slot[i]]) == key)
+      break;
+  return (i);
+}
+
+/*-- make the hash at least twice the size of 'need' edges, putting back
+     the 'cnt' edges already kept --*/
+static void edge_hash(need, cnt)
+int need, cnt;
+{
+  int i, n;
+
+  for (n=64; n < 2 * need; n*=2);
+  edge_slot = (int *) grow((char *) edge_slot, &edge_max, n, sizeof(int));
+  edge_mask = n - 1;
+  for (i=0; i<n; i++)
+    edge_slot[i] = -1;
+  for (i=0; i<cnt; i++)
+    edge_slot[edge_slot_of(edge_key(&file_bdr[i]))] = i;
+  hash_cnt = cnt;
+}
+
+/*-- forget the edge hash and the chains: file_bdr and file_bdr_seg have
+     been put back from a copy (watch.c) --*/
+void border_stale()
+{
+  hash_cnt = -1;
+  lines_valid = FALSE;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  border_add                                                      *
+ *                                                                           *
+ * Purpose:  Keep edge 'edge' of absolute hex [col, row] as a border, in     *
+ *           file_bdr and, folded into the subsector gen_sector() draws, in  *
+ *           file_bdr_seg; unless the same edge, seen from either side, is   *
+ *           already kept.  Returns FALSE for a duplicate.                   *
+ *                                                                           *
+ *****************************************************************************/
+
+int border_add(col, row, edge)
+int col, row, edge;
+{
+  int i, lx, ly, x_off, y_off, next_edge;
+  unsigned slot;
+  Border b;
+
+  if (hash_cnt != private_bdr_cnt)
+    edge_hash(private_bdr_cnt, private_bdr_cnt);
+  else if (2 * (private_bdr_cnt + 1) > (int) edge_mask + 1)
+    edge_hash(private_bdr_cnt + 1, private_bdr_cnt);
+  b.col = col;
+  b.row = row;
+  b.edge = edge;
+  slot = edge_slot_of(edge_key(&b));
+  if (edge_slot[slot] >= 0)
+    return (FALSE);
+
+  i = private_bdr_cnt;
+  file_bdr = (Border *) grow((char *) file_bdr, &bdr_max, i, sizeof(Border));
+  file_bdr_seg = (XSegment *) grow((char *) file_bdr_seg, &seg_max, i,
+                sizeof(XSegment));
+  file_bdr[i] = b;
+  lx = ((col % NUM_HEXES) + NUM_HEXES) % NUM_HEXES;
+  ly = ((row % NUM_LINES) + NUM_LINES) % NUM_LINES;
+  next_edge = (edge + 1) % 6;
+  x_off = hex_loc[lx].x;
+  y_off = hex_loc[lx].y + (ly * LINE_INC) + PAD;
+  file_bdr_seg[i].x1 = abs_hex_pts[edge].x + x_off;
+  file_bdr_seg[i].y1 = abs_hex_pts[edge].y + y_off;
+  file_bdr_seg[i].x2 = abs_hex_pts[next_edge].x + x_off;
+  file_bdr_seg[i].y2 = abs_hex_pts[next_edge].y + y_off;
+  edge_slot[slot] = i;
+  hash_cnt = ++private_bdr_cnt;
+  lines_valid = FALSE;
+  return (TRUE);
+}
+
+/*****************************************************************************
+ **
+ **  Chaining works on the ends of the folded segments.  Each distinct end
+ **  is a vertex; the segments at each vertex are counting-sorted into
+ **  vtx_first/vtx_seg, and a walk leaves a vertex by the next of its
+ **  segments not yet used.  The walks start from vertices with an odd
+ **  number of segments left first, as a polyline must end at each of
+ **  them; whatever is left is closed loops.
+ **
+ *****************************************************************************/
+
+static int *end_vtx, end_max;            /* vertex of segment end 2i, 2i+1 */
+static int *vtx_first, *vtx_seg, *vtx_next, vtx_max, vseg_max, vnext_max;
+static int *vtx_slot, slot_max;
+static char *seg_used;
+static int used_max;
+
+static void add_point(x, y)
+int x, y;
+{
+  BdrLine *l = &file_bdr_line[line_cnt];
+
+  file_bdr_pts = (XPoint *) grow((char *) file_bdr_pts, &pts_max,
+                l->first + l->npoints, sizeof(XPoint));
+  file_bdr_pts[l->first + l->npoints].x = x;
+  file_bdr_pts[l->first + l->npoints].y = y;
+  l->npoints++;
+}
+
+/*-- one polyline, from vertex 'v' for as long as there is an unused
+     segment to leave by --*/
+static void walk(v, next_pt)
+int v, *next_pt;
+{
+  XSegment *s;
+  int k, end;
+
+  file_bdr_line = (BdrLine *) grow((char *) file_bdr_line, &line_max,
+                line_cnt, sizeof(BdrLine));
+  file_bdr_line[line_cnt].first = *next_pt;
+  file_bdr_line[line_cnt].npoints = 0;
+  for (;;) {
+    while ((vtx_next[v] < vtx_first[v+1]) &&
+           seg_used[vtx_seg[vtx_next[v]] >> 1])
+      vtx_next[v]++;
+    if (vtx_next[v] == vtx_first[v+1])
+      break;
+    end = vtx_seg[vtx_next[v]++];
+    k = end >> 1;
+    seg_used[k] = TRUE;
+    s = &file_bdr_seg[k];
+    if (file_bdr_line[line_cnt].npoints == 0) {
+      if (end & 1)
+        add_point(s->x2, s->y2);
+      else
+        add_point(s->x1, s->y1);
+     }
+    if (end & 1)
+      add_point(s->x1, s->y1);
+    else
+      add_point(s->x2, s->y2);
+    v = end_vtx[end ^ 1];
+   }
+  *next_pt += file_bdr_line[line_cnt].npoints;
+  if (file_bdr_line[line_cnt].npoints > 0)
+    line_cnt++;
+}
+
+/*-- the number of segments at vertex 'v' not yet walked --*/
+static int unused(v)
+int v;
+{
+  int k, n;
+
+  n = 0;
+  for (k=vtx_next[v]; k<vtx_first[v+1]; k++)
+    if (!seg_used[vtx_seg[k] >> 1])
+      n++;
+  return (n);
+}
+
+static void chain()
+{
+  int i, k, n, v, x, y, next_pt, nvtx;
+  unsigned key, h, mask;
+
+/*--- number the distinct segment ends ---*/
+  n = 2 * private_bdr_cnt;
+  end_vtx = (int *) grow((char *) end_vtx, &end_max, n, sizeof(int));
+  for (k=64; k < 2 * n; k*=2);
+  vtx_slot = (int *) grow((char *) vtx_slot, &slot_max, k, sizeof(int));
+  mask = k - 1;
+  for (i=0; i<k; i++)
+    vtx_slot[i] = -1;
+  nvtx = 0;
+  for (i=0; i<n; i++) {
+    x = (i & 1) ? file_bdr_seg[i>>1].x2 : file_bdr_seg[i>>1].x1;
+    y = (i & 1) ? file_bdr_seg[i>>1].y2 : file_bdr_seg[i>>1].y1;
+    key = (((unsigned) x & 0xffff) << 16) | ((unsigned) y & 0xffff);
+    for (h=(key * 2654435761u >> 8) & mask; vtx_slot[h] >= 0; h=(h+1) & mask) {
+      v = vtx_slot[h];
+      if ((((v & 1) ? file_bdr_seg[v>>1].x2 : file_bdr_seg[v>>1].x1) == x) &&
+          (((v & 1) ? file_bdr_seg[v>>1].y2 : file_bdr_seg[v>>1].y1) == y))
+        break;
+     }
+    if (vtx_slot[h] < 0) {
+      vtx_slot[h] = i;
+      end_vtx[i] = nvtx++;
+     }
+    else
+      end_vtx[i] = end_vtx[vtx_slot[h]];
+   }
+
+/*--- the segment ends at each vertex ---*/
+  vtx_first = (int *) grow((char *) vtx_first, &vtx_max, nvtx + 1, sizeof(int));
+  vtx_next = (int *) grow((char *) vtx_next, &vnext_max, nvtx, sizeof(int));
+  vtx_seg = (int *) grow((char *) vtx_seg, &vseg_max, n, sizeof(int));
+  seg_used = grow(seg_used, &used_max, private_bdr_cnt, 1);
+  for (v=0; v<=nvtx; v++)
+    vtx_first[v] = 0;
+  for (i=0; i<n; i++)
+    vtx_first[end_vtx[i]+1]++;
+  for (v=0; v<nvtx; v++)
+    vtx_first[v+1] += vtx_first[v];
+  for (v=0; v<nvtx; v++)
+    vtx_next[v] = vtx_first[v];
+  for (i=0; i<n; i++)
+    vtx_seg[vtx_next[end_vtx[i]]++] = i;
+  for (v=0; v<nvtx; v++)
+    vtx_next[v] = vtx_first[v];
+  for (i=0; i<private_bdr_cnt; i++)
+    seg_used[i] = FALSE;
+
+/*--- the walks: from the odd vertices, then round what is left.  A walk
+      from a vertex with an odd number of segments left ends at another,
+      leaving both even, so each odd vertex starts at most one ---*/
+  line_cnt = 0;
+  next_pt = 0;
+  for (v=0; v<nvtx; v++)
+    if (unused(v) & 1)
+      walk(v, &next_pt);
+  for (v=0; v<nvtx; v++)
+    while (vtx_next[v] < vtx_first[v+1])
+      walk(v, &next_pt);
+  lines_valid = TRUE;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  border_lines                                                    *
+ *                                                                           *
+ * Purpose:  The number of polylines the file borders make; polyline i is    *
+ *           the file_bdr_line[i].npoints points from file_bdr_pts[          *
+ *           file_bdr_line[i].first], in CoordModeOrigin.  They are chained  *
+ *           again only after a border has been added.                       *
+ *                                                                           *
+ *****************************************************************************/
+
+int border_lines()
+{
+  if (private_bdr_cnt == 0)
+    return (0);
+  if (!lines_valid)
+    chain();
+  return (line_cnt);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  border_claims                                                   *
+ *                                                                           *
+ * Purpose:  Add the borders between polities, worked out from allegiances,  *
+ *           over View 'v' (or the subsector of the worlds loaded, if 'v' is *
+ *           NULL).  Each world with an allegiance claims the hexes within   *
+ *           'radius' jumps of it that no nearer world has claimed; a tie    *
+ *           goes to the world read last, as in hex_index().  The claims are *
+ *           made by one breadth-first pass out from every world at once,    *
+ *           seeded from the last world back, so each hex is visited once    *
+ *           whatever the radius, and an edge becomes a border when the      *
+ *           hexes either side of it are not both unclaimed and are not      *
+ *           claimed by the same allegiance.  No border is drawn round the   *
+ *           edge of the View.                                               *
+ *                                                                           *
+ *****************************************************************************/
+
+static int *claim, *dist, *queue, claim_max, dist_max, queue_max;
+
+/*-- TRUE if allegiance 'a' is a polity: not blank, "--" or non-aligned --*/
+static int polity(a)
+char *a;
+{
+  return ((a[0] != '\0') && (a[0] != ' ') && (a[0] != '-') &&
+          (strncmp(a, "Na", 2) != 0));
+}
+
+/*-- TRUE if the hexes claimed by worlds 'a' and 'b' (-1 for none) are on
+     the same side of a border --*/
+static int same_claim(a, b)
+int a, b;
+{
+  if ((a < 0) || (b < 0))
+    return (a == b);
+  return (strncmp(sec_world[a].allegiance, sec_world[b].allegiance, 2) == 0);
+}
+
+void border_claims(v, radius)
+View *v;
+int radius;
+{
+  View sub;
+  int i, k, n, c, r, nc, nr, e, head, tail;
+
+  if (v == NULL) {
+    if (!loaded_subsector(&sub))
+      return;
+    v = &sub;
+   }
+  n = v->cols * v->rows;
+  claim = (int *) grow((char *) claim, &claim_max, n, sizeof(int));
+  dist = (int *) grow((char *) dist, &dist_max, n, sizeof(int));
+  queue = (int *) grow((char *) queue, &queue_max, n, sizeof(int));
+  for (k=0; k<n; k++)
+    claim[k] = -1;
+
+/*--- every world claims its own hex, then the claims spread a ring at a
+      time; a hex joins the claim that reaches it first, and the last world
+      read is queued first so it wins a tie ---*/
+  tail = 0;
+  for (i=w_cnt-1; i>=0; i--) {
+    c = sec_world[i].col - v->col;
+    r = sec_world[i].row - v->row;
+    if ((c < 0) || (c >= v->cols) || (r < 0) || (r >= v->rows) ||
+        !polity(sec_world[i].allegiance))
+      continue;
+    k = r * v->cols + c;
+    if (claim[k] >= 0)
+      continue;
+    claim[k] = i;
+    dist[k] = 0;
+    queue[tail++] = k;
+   }
+  for (head=0; head<tail; head++) {
+    k = queue[head];
+    if (dist[k] == radius)
+      continue;
+    c = k % v->cols + v->col;
+    r = k / v->cols + v->row;
+    for (e=0; e<6; e++) {
+      nc = c + across_col[e] - v->col;
+      nr = r + across_row[c & 1][e] - v->row;
+      if ((nc < 0) || (nc >= v->cols) || (nr < 0) || (nr >= v->rows) ||
+          (claim[nr * v->cols + nc] >= 0))
+        continue;
+      claim[nr * v->cols + nc] = claim[k];
+      dist[nr * v->cols + nc] = dist[k] + 1;
+      queue[tail++] = nr * v->cols + nc;
+     }
+   }
+
+/*--- edges 0, 1 and 2 of every hex are every edge inside the View once ---*/
+  for (k=0; k<n; k++) {
+    c = k % v->cols + v->col;
+    r = k / v->cols + v->row;
+    for (e=0; e<3; e++) {
+      nc = c + across_col[e] - v->col;
+      nr = r + across_row[c & 1][e] - v->row;
+      if ((nc < 0) || (nc >= v->cols) || (nr < 0) || (nr >= v->rows))
+        continue;
+      if (!same_claim(claim[k], claim[nr * v->cols + nc]))
+        border_add(c, r, e);
+     }
+   }
+}
@@ -0,0 +1,342 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       The compiled datafile cache.  The first time a
+ **                     datafile is read, what read_sector_file() made of
+ **                     it (the worlds and routes, as they are kept in
+ **                     sec_world and t_route, the border edges and the
+ **                     title) is written next to it as 'file.ssvc'.  Later
+ **                     reads map that file and copy the records straight
+ **                     in, with no parsing.  The cache records the
+ **                     datafile's size, modification time and a hash of
+ **                     its text; if the time has changed the text is hashed
+ **                     again, and the cache is made again unless the text
+ **                     is the same.  A cache of another version, or from a
+ **                     program with records of another size or byte order,
+ **                     is made again too.
+ **
+ **                     The border edges are kept as they were in the file,
+ **                     not as segments: they are put through border_add()
+ **                     on loading, as the segments depend on the scale and
+ **                     an edge may be a duplicate of one in another file.
+ **
+ **  File:              cache.c, containing the following subroutines:
+ **                       cache_load()
+ **                       cache_begin()
+ **                       cache_border()
+ **                       cache_save()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC    "SSVC"
+#define CACHE_VERSION  3       /* 2: tab delimited datafiles, 3: lines */
+#define CACHE_ORDER    0x01020304
+
+/*-- the start of a cache file; the worlds, routes and border edges follow,
+     in that order --*/
+typedef struct _cachehead {
+        char magic[4];
+        int version, order;
+        int world_size, route_size, border_size;
+        long mtime, mtime_ns, size;        /* of the datafile        */
+        unsigned long hash;                /* of its text            */
+        int has_title;
+        char title[80];
+        long lines;                        /* parsed, for '--stats'  */
+        int w_cnt, tr_cnt, bdr_cnt;        /* at sector [0, 0]       */
+        } CacheHead;
+
+int cache_enabled = TRUE;       /* '--no-cache' turns it off */
+int titles_read;                /* '@' lines parse_sector_line() has read */
+
+/*-- what is being compiled: the datafile's state before it was read, and
+     the first world, route and title count it was read on top of --*/
+static int compiling = FALSE;
+static struct stat src_st;
+static int first_world, first_route, first_title;
+static long first_line;
+static Border *raw_bdr;
+static int raw_cnt, raw_max;
+
+/*-- the cache file of datafile 'name' --*/
+static char *cache_name(name)
+char *name;
+{
+  static char *buf;
+  static int max;
+
+  buf = grow(buf, &max, strlen(name) + 6, 1);
+  sprintf(buf, "%s.ssvc", name);
+  return (buf);
+}
+
+/*-- world 'w' as it goes into the cache, moved back by 'dc' columns and
+     'dr' rows: field by field into a cleared record, so neither the padding
+     nor what lies past the end of a name gets in and the same datafile
+     always makes the same cache file --*/
+static void cache_world(c, w, dc, dr)
+World *c, *w;
+int dc, dr;
+{
+  memset((char *) c, 0, sizeof(*c));
+  c->location.x = w->location.x;
+  c->location.y = w->location.y;
+  c->col = w->col - dc;
+  c->row = w->row - dr;
+  c->WorldType = w->WorldType;
+  c->GasGiant = w->GasGiant;
+  strncpy(c->Starport, w->Starport, sizeof(c->Starport) - 1);
+  strncpy(c->Base, w->Base, sizeof(c->Base) - 1);
+  strncpy(c->Zone, w->Zone, sizeof(c->Zone) - 1);
+  strncpy(c->hex, w->hex, sizeof(c->hex) - 1);
+  strncpy(c->name, w->name, sizeof(c->name) - 1);
+  strncpy(c->uwp, w->uwp, sizeof(c->uwp) - 1);
+  strncpy(c->notes, w->notes, sizeof(c->notes) - 1);
+  strncpy(c->allegiance, w->allegiance, sizeof(c->allegiance) - 1);
+  strncpy(c->pbg, w->pbg, sizeof(c->pbg) - 1);
+}
+
+/*-- FNV-1a over 'size' bytes of text --*/
+static unsigned long text_hash(text, size)
+char *text;
+long size;
+{
+  unsigned long h = 14695981039346656037UL;
+  long i;
+
+  for (i=0; i<size; i++) {
+    h ^= (unsigned char) text[i];
+    h *= 1099511628211UL;
+   }
+  return (h);
+}
+
+/*-- TRUE if the text of datafile 'name' still hashes to what 'h' says it
+     did; the cache file's header is then brought up to the new time --*/
+static int same_text(name, st, h)
+char *name;
+struct stat *st;
+CacheHead *h;
+{
+  TextFile tf;
+  CacheHead head;
+  int fd, same;
+
+  if (!open_text(name, &tf))
+    return (FALSE);
+  same = (text_hash(tf.text, tf.size) == h->hash);
+  close_text(&tf);
+  if (same && ((fd = open(cache_name(name), O_WRONLY)) >= 0)) {
+    head = *h;
+    head.mtime = st->st_mtim.tv_sec;
+    head.mtime_ns = st->st_mtim.tv_nsec;
+    (void) write(fd, (char *) &head, sizeof(head));
+    close(fd);
+   }
+  return (same);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  cache_load                                                      *
+ *                                                                           *
+ * Purpose:  Append what datafile 'name' holds to what is loaded, as         *
+ *           read_sector_file(name, sx, sy) would, from its cache file.      *
+ *           Returns FALSE, having loaded nothing, if there is no cache, or  *
+ *           it is not one this program wrote, or the datafile has changed.  *
+ *                                                                           *
+ *****************************************************************************/
+
+int cache_load(name, sx, sy)
+char *name;
+int sx, sy;
+{
+  struct stat st;
+  TextFile tf;
+  CacheHead *h;
+  World *w;
+  Route *rt;
+  Border *b;
+  int i, dc, dr;
+
+  if (!cache_enabled || (stat(name, &st) != 0) || !S_ISREG(st.st_mode))
+    return (FALSE);
+  if (!open_text(cache_name(name), &tf))
+    return (FALSE);
+  h = (CacheHead *) tf.text;
+  if ((tf.size < sizeof(CacheHead)) ||
+      (memcmp(h->magic, CACHE_MAGIC, 4) != 0) ||
+      (h->version != CACHE_VERSION) || (h->order != CACHE_ORDER) ||
+      (h->world_size != sizeof(World)) || (h->route_size != sizeof(Route)) ||
+      (h->border_size != sizeof(Border)) ||
+      (h->w_cnt < 0) || (h->tr_cnt < 0) || (h->bdr_cnt < 0) ||
+      (tf.size != sizeof(CacheHead) + h->w_cnt * sizeof(World) +
+                h->tr_cnt * sizeof(Route) + h->bdr_cnt * sizeof(Border)) ||
+      (h->size != st.st_size) ||
+      (((h->mtime != st.st_mtim.tv_sec) || (h->mtime_ns != st.st_mtim.tv_nsec))
+       && !same_text(name, &st, h))) {
+    close_text(&tf);
+    return (FALSE);
+   }
+
+/*--- the records are for sector [0, 0]: move them to [sx, sy] ---*/
+  dc = sx * SECTOR_COLS;
+  dr = sy * SECTOR_ROWS;
+  w = (World *) (tf.text + sizeof(CacheHead));
+  if (h->w_cnt > 0) {
+    sec_world = (World *) grow((char *) sec_world, &w_max, w_cnt + h->w_cnt,
+                sizeof(World));
+    memcpy((char *) &sec_world[w_cnt], (char *) w, h->w_cnt * sizeof(World));
+    if (dc || dr)
+      for (i=w_cnt; i<w_cnt+h->w_cnt; i++) {
+        sec_world[i].col += dc;
+        sec_world[i].row += dr;
+       }
+    w_cnt += h->w_cnt;
+   }
+  rt = (Route *) (w + h->w_cnt);
+  if (h->tr_cnt > 0) {
+    t_route = (Route *) grow((char *) t_route, &tr_max, tr_cnt + h->tr_cnt,
+                sizeof(Route));
+    memcpy((char *) &t_route[tr_cnt], (char *) rt, h->tr_cnt * sizeof(Route));
+    if (dc || dr)
+      for (i=tr_cnt; i<tr_cnt+h->tr_cnt; i++) {
+        t_route[i].c1 += dc;
+        t_route[i].r1 += dr;
+        t_route[i].c2 += dc;
+        t_route[i].r2 += dr;
+       }
+    tr_cnt += h->tr_cnt;
+   }
+  b = (Border *) (rt + h->tr_cnt);
+  for (i=0; i<h->bdr_cnt; i++)
+    border_add(b[i].col + dc, b[i].row + dr, b[i].edge);
+  if (h->has_title) {
+    memcpy(title, h->title, sizeof(h->title));
+    title[sizeof(h->title) - 1] = '\0';
+   }
+  stats_lines += h->lines;
+  close_text(&tf);
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: cache_begin, cache_border, cache_save                           *
+ *                                                                           *
+ * Purpose:  Compile datafile 'name' while read_sector_file() parses it.     *
+ *           cache_begin() is called before the file is opened, so a change  *
+ *           made while it is read shows as a new time next time.            *
+ *           load_bdr_seg() passes each border edge to cache_border() as it  *
+ *           was in the file, from hex [0, 0] of sector [0, 0].              *
+ *           cache_save() is given the text that was parsed and writes the   *
+ *           cache file; if it cannot, the file is parsed again next time.   *
+ *                                                                           *
+ *****************************************************************************/
+
+void cache_begin(name)
+char *name;
+{
+  compiling = cache_enabled && (stat(name, &src_st) == 0) &&
+                S_ISREG(src_st.st_mode);
+  first_world = w_cnt;
+  first_route = tr_cnt;
+  first_title = titles_read;
+  first_line = stats_lines;
+  raw_cnt = 0;
+}
+
+void cache_border(col, row, edge)
+int col, row, edge;
+{
+  if (!compiling)
+    return;
+  raw_bdr = (Border *) grow((char *) raw_bdr, &raw_max, raw_cnt,
+                sizeof(Border));
+  raw_bdr[raw_cnt].col = col;
+  raw_bdr[raw_cnt].row = row;
+  raw_bdr[raw_cnt++].edge = edge;
+}
+
+void cache_save(name, text, size, sx, sy)
+char *name, *text;
+long size;
+int sx, sy;
+{
+  CacheHead head;
+  World w;
+  Route rt;
+  char *tmp;
+  FILE *out;
+  int i, ok;
+
+  if (!compiling)
+    return;
+  compiling = FALSE;
+  memset((char *) &head, 0, sizeof(head));
+  memcpy(head.magic, CACHE_MAGIC, 4);
+  head.version = CACHE_VERSION;
+  head.order = CACHE_ORDER;
+  head.world_size = sizeof(World);
+  head.route_size = sizeof(Route);
+  head.border_size = sizeof(Border);
+  head.mtime = src_st.st_mtim.tv_sec;
+  head.mtime_ns = src_st.st_mtim.tv_nsec;
+  head.size = src_st.st_size;
+  head.hash = text_hash(text, size);
+  if ((head.has_title = (titles_read != first_title)))
+    strcpy(head.title, title);
+  head.lines = stats_lines - first_line;
+  head.w_cnt = w_cnt - first_world;
+  head.tr_cnt = tr_cnt - first_route;
+  head.bdr_cnt = raw_cnt;
+
+/*--- written under another name and renamed, so a reader never sees half
+      of it, nor two writers each other's ---*/
+  tmp = (char *) malloc(strlen(name) + 32);
+  if (tmp == NULL)
+    return;
+  sprintf(tmp, "%s.ssvc.%ld", name, (long) getpid());
+  if ((out = fopen(tmp, "w")) == NULL) {
+    free(tmp);
+    return; }
+  ok = (fwrite((char *) &head, sizeof(head), 1, out) == 1);
+  for (i=first_world; ok && (i<w_cnt); i++) {
+    cache_world(&w, &sec_world[i], sx * SECTOR_COLS, sy * SECTOR_ROWS);
+    ok = (fwrite((char *) &w, sizeof(w), 1, out) == 1);
+   }
+  for (i=first_route; ok && (i<tr_cnt); i++) {
+    memset((char *) &rt, 0, sizeof(rt));
+    rt.x1 = t_route[i].x1;
+    rt.y1 = t_route[i].y1;
+    rt.x2 = t_route[i].x2;
+    rt.y2 = t_route[i].y2;
+    rt.c1 = t_route[i].c1 - sx * SECTOR_COLS;
+    rt.r1 = t_route[i].r1 - sy * SECTOR_ROWS;
+    rt.c2 = t_route[i].c2 - sx * SECTOR_COLS;
+    rt.r2 = t_route[i].r2 - sy * SECTOR_ROWS;
+    ok = (fwrite((char *) &rt, sizeof(rt), 1, out) == 1);
+   }
+  if (ok && (raw_cnt > 0))
+    ok = (fwrite((char *) raw_bdr, sizeof(Border), raw_cnt, out) == raw_cnt);
+  if ((fclose(out) != 0) || !ok || (rename(tmp, cache_name(name)) != 0))
+    unlink(tmp);
+  free(tmp);
+}
@@ -0,0 +1,266 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Spatial lookup for partial repaints of the subsector
+ **                     map.  The map window is cut into cells one hex column
+ **                     wide and one hex row tall; every route, hex outline,
+ **                     border segment and world is listed in each cell its
+ **                     drawing can touch.  While sector_area is set, the
+ **                     gen_sector() steps ask sector_find() for the items
+ **                     that meet it instead of drawing everything, so
+ **                     repairing a damaged corner visits only the few hexes
+ **                     around it.
+ **
+ **  File:              damage.c, containing the following subroutines:
+ **                       sector_index_stale()
+ **                       sector_find()
+ **                       world_box()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+#define CELL_W      COL_INC            /* one hex column */
+#define CELL_H      LINE_INC           /* one hex row    */
+#define CELLS_X     ((MAP_WIDTH + CELL_W - 1) / CELL_W)
+#define CELLS_Y     ((MAP_HEIGHT + CELL_H - 1) / CELL_H)
+#define NUM_CELLS   (CELLS_X * CELLS_Y)
+
+XRectangle *sector_area = NULL;
+
+static int index_valid = FALSE;
+static int item_cnt[NUM_ITEMS];
+static XRectangle *item_box[NUM_ITEMS];
+static int *cell_first[NUM_ITEMS], *cell_list[NUM_ITEMS];
+static int *item_mark[NUM_ITEMS], mark_gen;
+static int *found;
+static int found_max, box_max[NUM_ITEMS], mark_max[NUM_ITEMS];
+
+/*-- forget the index: the data or the interactive borders have changed --*/
+void sector_index_stale()
+{
+  index_valid = FALSE;
+}
+
+static void set_box(b, x1, y1, x2, y2, pad)
+XRectangle *b;
+int x1, y1, x2, y2, pad;
+{
+  b->x = ((x1 < x2) ? x1 : x2) - pad;
+  b->y = ((y1 < y2) ? y1 : y2) - pad;
+  b->width = ((x1 < x2) ? x2 - x1 : x1 - x2) + 2 * pad + 1;
+  b->height = ((y1 < y2) ? y2 - y1 : y1 - y2) + 2 * pad + 1;
+}
+
+/*-- the part of the map a world can draw on, labels included (also used
+     by watch.c) --*/
+void world_box(dev, w, b)
+Device *dev;
+World *w;
+XRectangle *b;
+{
+  int x_ctr, y_ctr, half, len;
+
+  x_ctr = hex_ctr[w->location.x+HEX_PAD].x;
+  y_ctr = hex_ctr[w->location.x+HEX_PAD].y + (w->location.y * LINE_INC);
+  half = S(48);
+  len = (*dev->width)(dev, FONT_BOLD, w->name, strlen(w->name)) / 2 + 1;
+  if (len > half) half = len;
+  len = (*dev->width)(dev, FONT_NORMAL, w->notes, strlen(w->notes)) / 2 + S(26);
+  if (len > half) half = len;
+  set_box(b, x_ctr - half, y_ctr - S(52) + PAD, x_ctr + half,
+                y_ctr + S(52) + PAD, 0);
+}
+
+/*-- the box around a chain of file borders --*/
+static void line_box(l, b)
+BdrLine *l;
+XRectangle *b;
+{
+  XPoint *p = &file_bdr_pts[l->first];
+  int i, x1, y1, x2, y2;
+
+  x1 = x2 = p[0].x;
+  y1 = y2 = p[0].y;
+  for (i=1; i<l->npoints; i++) {
+    if (p[i].x < x1) x1 = p[i].x;
+    if (p[i].x > x2) x2 = p[i].x;
+    if (p[i].y < y1) y1 = p[i].y;
+    if (p[i].y > y2) y2 = p[i].y;
+   }
+  set_box(b, x1, y1, x2, y2, S(3));
+}
+
+/*-- the range of cells a box covers, clipped to the map --*/
+static int cell_range(b, c0, r0, c1, r1)
+XRectangle *b;
+int *c0, *r0, *c1, *r1;
+{
+  *c0 = (b->x < 0) ? 0 : b->x / CELL_W;
+  *r0 = (b->y < 0) ? 0 : b->y / CELL_H;
+  *c1 = (b->x + (int) b->width - 1) / CELL_W;
+  *r1 = (b->y + (int) b->height - 1) / CELL_H;
+  if (*c1 >= CELLS_X) *c1 = CELLS_X - 1;
+  if (*r1 >= CELLS_Y) *r1 = CELLS_Y - 1;
+  return ((b->x + (int) b->width > 0) && (b->y + (int) b->height > 0) &&
+          (*c0 < CELLS_X) && (*r0 < CELLS_Y));
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  sector_index                                                    *
+ *                                                                           *
+ * Purpose:  Work out the box each item draws in and list the items by       *
+ *           cell.  Both lists are counting-sorted, as in map_index(): the   *
+ *           items of cell k are cell_list[cell_first[k]..cell_first[k+1]-1] *
+ *                                                                           *
+ *****************************************************************************/
+
+static void sector_index(dev)
+Device *dev;
+{
+  int kind, i, k, c, r, c0, r0, c1, r1, pass;
+  XSegment seg;
+  XRectangle *b;
+
+  item_cnt[ITEM_ROUTE] = tr_cnt;
+  item_cnt[ITEM_HEX] = NUM_HEXES * NUM_LINES;
+  item_cnt[ITEM_BORDER] = bdr_cnt;
+  item_cnt[ITEM_FILE_BORDER] = border_lines();
+  item_cnt[ITEM_WORLD] = w_cnt;
+
+  for (kind=0; kind<NUM_ITEMS; kind++) {
+    item_box[kind] = (XRectangle *) grow((char *) item_box[kind],
+                &box_max[kind], item_cnt[kind], sizeof(XRectangle));
+    item_mark[kind] = (int *) grow((char *) item_mark[kind],
+                &mark_max[kind], item_cnt[kind], sizeof(int));
+    for (i=0; i<item_cnt[kind]; i++) {
+      b = &item_box[kind][i];
+      item_mark[kind][i] = 0;
+      switch (kind) {
+        case ITEM_ROUTE       : if (route_segment(&t_route[i], &seg))
+                                  set_box(b, seg.x1, seg.y1, seg.x2, seg.y2, S(3));
+                                else
+                                  set_box(b, -1000, -1000, -1000, -1000, 0);
+                                break;
+        case ITEM_HEX         : c = hex_loc[i % NUM_HEXES].x;
+                                r = hex_loc[i % NUM_HEXES].y +
+                                        (i / NUM_HEXES) * LINE_INC + PAD;
+                                set_box(b, c - S(30), r, c + COL_INC, r + LINE_INC, 1);
+                                break;
+        case ITEM_BORDER      : set_box(b, bdr_seg[i].x1, bdr_seg[i].y1,
+                                        bdr_seg[i].x2, bdr_seg[i].y2, S(3));
+                                break;
+        case ITEM_FILE_BORDER : line_box(&file_bdr_line[i], b);
+                                break;
+        case ITEM_WORLD       : world_box(dev, &sec_world[i], b);
+                                break;
+       }
+     }
+
+/*--- an item goes in every cell its box touches; 1st pass counts ---*/
+    free(cell_first[kind]);
+    free(cell_list[kind]);
+    if ((cell_first[kind] = (int *) calloc(NUM_CELLS + 1, sizeof(int)))
+        == NULL) {
+      fprintf(stderr, "%s: Out of memory\n", program_name);
+      exit(1); }
+    cell_list[kind] = NULL;
+    for (pass=0; pass<2; pass++) {
+      for (i=0; i<item_cnt[kind]; i++) {
+        if (!cell_range(&item_box[kind][i], &c0, &r0, &c1, &r1))
+          continue;
+        for (r=r0; r<=r1; r++)
+          for (c=c0; c<=c1; c++) {
+            k = r * CELLS_X + c;
+            if (pass == 0)
+              cell_first[kind][k+1]++;
+            else
+              cell_list[kind][cell_first[kind][k]++] = i;
+           }
+       }
+      if (pass == 0) {
+        for (k=0; k<NUM_CELLS; k++)
+          cell_first[kind][k+1] += cell_first[kind][k];
+        cell_list[kind] = (int *) malloc((cell_first[kind][NUM_CELLS] + 1) *
+                sizeof(int));
+        if (cell_list[kind] == NULL) {
+          fprintf(stderr, "%s: Out of memory\n", program_name);
+          exit(1); }
+       }
+     }
+    for (k=NUM_CELLS; k>0; k--)
+      cell_first[kind][k] = cell_first[kind][k-1];
+    cell_first[kind][0] = 0;
+   }
+  index_valid = TRUE;
+}
+
+static int by_index(a, b)
+int *a, *b;
+{
+  return (*a - *b);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  sector_find                                                     *
+ *                                                                           *
+ * Purpose:  Point *list at the items of one kind (ITEM_ROUTE, ...) to draw, *
+ *           in drawing order, and return how many there are: every item if  *
+ *           sector_area is NULL, otherwise those whose box meets it.  The   *
+ *           list is only good until the next call.                          *
+ *                                                                           *
+ *****************************************************************************/
+
+int sector_find(dev, kind, list)
+Device *dev;
+int kind, **list;
+{
+  int i, k, c, r, c0, r0, c1, r1, n, cnt;
+  XRectangle *a, *b;
+
+  cnt = (kind == ITEM_ROUTE) ? tr_cnt : (kind == ITEM_HEX) ?
+        NUM_HEXES * NUM_LINES : (kind == ITEM_BORDER) ? bdr_cnt :
+        (kind == ITEM_FILE_BORDER) ? border_lines() : w_cnt;
+  found = (int *) grow((char *) found, &found_max, cnt, sizeof(int));
+  *list = found;
+  if ((a = sector_area) == NULL) {
+    for (i=0; i<cnt; i++)
+      found[i] = i;
+    return (cnt);
+   }
+  if (!index_valid)
+    sector_index(dev);
+
+  n = 0;
+  mark_gen++;
+  if (cell_range(a, &c0, &r0, &c1, &r1))
+    for (r=r0; r<=r1; r++)
+      for (c=c0; c<=c1; c++) {
+        k = r * CELLS_X + c;
+        for (i=cell_first[kind][k]; i<cell_first[kind][k+1]; i++) {
+          if (item_mark[kind][cell_list[kind][i]] == mark_gen) continue;
+          item_mark[kind][cell_list[kind][i]] = mark_gen;
+          b = &item_box[kind][cell_list[kind][i]];
+          if ((b->x >= a->x + (int) a->width) || (a->x >= b->x + (int) b->width) ||
+              (b->y >= a->y + (int) a->height) || (a->y >= b->y + (int) b->height))
+            continue;
+          found[n++] = cell_list[kind][i];
+         }
+       }
+  qsort((char *) found, n, sizeof(int), by_index);
+  return (n);
+}
@@ -0,0 +1,230 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       The pixel geometry of the map at a given scale
+ **                     ('-z').  Every length the drawing code uses -- the
+ **                     hex grid, the window, the offsets of the parts of a
+ **                     world -- is a length at scale 1 looked up in the
+ **                     current Geometry: S(45) is 45 pixels at this scale.
+ **                     The tables are worked out once, the first time a
+ **                     scale is asked for, and kept; so are the base
+ **                     symbol bitmaps scaled to it.  At most MAX_SCALES
+ **                     are kept at once: a new scale after that takes the
+ **                     place of the one least recently used.
+ **
+ **  File:              geometry.c, containing the following subroutines:
+ **                       set_scale()
+ **                       scale_bitmap()
+ **                       scaled_symbol()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <math.h>
+
+Geometry *geom;
+
+static Geometry *geom_cache[MAX_SCALES];
+static int geom_cnt;
+static long geom_uses;
+
+/*****************************************************************************
+ **
+ **  The hex grid is laid out on a lattice, so that rounding each length
+ **  separately at an odd scale cannot open gaps between hexes: a hex is
+ **  S(60) across the top, S(30) more to each side and 2*S(50) high, and
+ **  the columns are S(60)+S(30) apart.  At scale 1 these are the tables
+ **  the map has always used:
+ **
+ **    hex_ctr   the hex centers of one row (from left to right), with 4
+ **              more at either end, so that X-boat routes can be drawn up
+ **              to 4 hexes off either side of the subsector.
+ **    hex_loc   the '0' point of each hex in a row, put into hex_pts[0]
+ **              as each hex is drawn.
+ **    hex_pts   the 6 points of a hex in CoordModePrevious     0_1
+ **              format, ordered as shown at right.           5/   \2
+ **    abs_hex_pts  the same points, relative to point 0,      \4_3/
+ **              for the borders read from the datafile.
+ **
+ *****************************************************************************/
+
+static void set_hexes(g)
+Geometry *g;
+{
+  int i, c30, c60, half;
+
+  c30 = g->px[30];
+  c60 = g->px[60];
+  half = g->px[50];
+  g->col_inc = c30 + c60;
+  g->line_inc = 2 * half;
+
+  for (i=0; i<NUM_HEXES; i++) {
+    g->loc[i].x = g->px[40] + g->col_inc * i;
+    g->loc[i].y = g->px[10] + half * (i & 1);
+   }
+  for (i=0; i<NUM_HEXES+8; i++) {
+    g->ctr[i].x = g->px[40] + g->col_inc * (i - HEX_PAD) + c30;
+    g->ctr[i].y = g->px[10] + half * (i & 1) + half;
+   }
+
+  g->pts[0].x = 0;     g->pts[0].y = 0;
+  g->pts[1].x = c60;   g->pts[1].y = 0;
+  g->pts[2].x = c30;   g->pts[2].y = half;
+  g->pts[3].x = -c30;  g->pts[3].y = half;
+  g->pts[4].x = -c60;  g->pts[4].y = 0;
+  g->pts[5].x = -c30;  g->pts[5].y = -half;
+  g->pts[6].x = c30;   g->pts[6].y = -half;
+
+  g->abs_pts[0].x = 0;           g->abs_pts[0].y = 0;
+  g->abs_pts[1].x = c60;         g->abs_pts[1].y = 0;
+  g->abs_pts[2].x = g->col_inc;  g->abs_pts[2].y = half;
+  g->abs_pts[3].x = c60;         g->abs_pts[3].y = 2 * half;
+  g->abs_pts[4].x = 0;           g->abs_pts[4].y = 2 * half;
+  g->abs_pts[5].x = -c30;        g->abs_pts[5].y = half;
+  g->abs_pts[6].x = 0;           g->abs_pts[6].y = 0;
+
+  g->pad = g->px[16];
+  g->map_width = g->px[50] + NUM_HEXES * g->col_inc;
+  g->map_height = NUM_LINES * g->line_inc + g->px[70] + g->pad;
+  g->print_height = g->map_height - g->pad + g->px[10];
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  set_scale                                                       *
+ *                                                                           *
+ * Purpose:  Make 'scale' the current scale (geom), working out its tables   *
+ *           if it has not been used before.  If MAX_SCALES are kept, the    *
+ *           one least recently made current is freed, with its symbols,     *
+ *           fonts and label layout, to make room.  Returns FALSE if the     *
+ *           scale is out of range (MIN_SCALE to MAX_SCALE).                 *
+ *                                                                           *
+ *****************************************************************************/
+
+int set_scale(scale)
+double scale;
+{
+  Geometry *g;
+  int i, slot;
+
+  if ((scale < MIN_SCALE) || (scale > MAX_SCALE))
+    return (FALSE);
+  for (i=0; i<geom_cnt; i++)
+    if (geom_cache[i]->scale == scale) {
+      geom = geom_cache[i];
+      geom->used = ++geom_uses;
+      return (TRUE);
+     }
+
+  if (geom_cnt < MAX_SCALES) {
+    if ((g = (Geometry *) calloc(1, sizeof(Geometry))) == NULL) {
+      fprintf(stderr, "%s: Out of memory\n", program_name);
+      exit(1); }
+    slot = geom_cnt;
+    geom_cache[geom_cnt++] = g;
+   }
+  else {
+/*--- reuse the least recently used; at scale 1 the symbols are base_sym's
+      own bits, not copies ---*/
+    slot = 0;
+    for (i=1; i<MAX_SCALES; i++)
+      if (geom_cache[i]->used < geom_cache[slot]->used)
+        slot = i;
+    g = geom_cache[slot];
+    if (g->scale != 1.0)
+      for (i=0; i<NUM_SYMS; i++)
+        if (g->sym[i].bits != NULL)
+          free(g->sym[i].bits);
+    raster_drop_scale(slot);
+    label_stale();
+    memset((char *) g, 0, sizeof(Geometry));
+   }
+  g->scale = scale;
+  g->slot = slot;
+  g->used = ++geom_uses;
+  for (i=0; i<MAX_PX; i++)
+    g->px[i] = (int) floor(i * scale + 0.5);
+  set_hexes(g);
+  geom = g;
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  scale_bitmap                                                    *
+ *                                                                           *
+ * Purpose:  Scale a bitmap in xbm order (LSB first, rows padded to a byte)  *
+ *           to the current scale, nearest neighbour.  The bitmap is a strip *
+ *           of cells 'cell' pixels wide (a font; a symbol is one cell) and  *
+ *           each is scaled on its own to 'new_cell' x 'new_height', so the  *
+ *           cells stay a whole number of pixels apart.                      *
+ *                                                                           *
+ *****************************************************************************/
+
+char *scale_bitmap(bits, width, height, cell, new_cell, new_height)
+char *bits;
+int width, height, cell, new_cell, new_height;
+{
+  int cells, bpl, new_bpl, i, j, k, sx, sy;
+  char *new_bits;
+
+  cells = width / cell;
+  bpl = (width + 7) / 8;
+  new_bpl = (cells * new_cell + 7) / 8;
+  if ((new_bits = calloc(new_bpl * new_height, 1)) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", program_name);
+    exit(1); }
+  for (j=0; j<new_height; j++) {
+    sy = (int) (j / geom->scale);
+    if (sy >= height) sy = height - 1;
+    for (k=0; k<cells; k++)
+      for (i=0; i<new_cell; i++) {
+        sx = (int) (i / geom->scale);
+        if (sx >= cell) sx = cell - 1;
+        sx += k * cell;
+        if ((bits[sy*bpl + (sx>>3)] >> (sx & 7)) & 1)
+          new_bits[j*new_bpl + ((k*new_cell+i)>>3)] |= 1 << ((k*new_cell+i) & 7);
+       }
+   }
+  return (new_bits);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  scaled_symbol                                                   *
+ *                                                                           *
+ * Purpose:  Base symbol 'sym' (SYM_NAVAL1, ...) at the current scale.  It   *
+ *           is scaled the first time it is asked for and then kept.         *
+ *                                                                           *
+ *****************************************************************************/
+
+Symbol *scaled_symbol(sym)
+int sym;
+{
+  Symbol *s = &geom->sym[sym], *b = &base_sym[sym];
+
+  if (s->bits != NULL)
+    return (s);
+  if (geom->scale == 1.0) {
+    *s = *b;
+    return (s);
+   }
+  s->width = (S(b->width) > 0) ? S(b->width) : 1;
+  s->height = (S(b->height) > 0) ? S(b->height) : 1;
+  s->bits = scale_bitmap(b->bits, b->width, b->height, b->width, s->width,
+                s->height);
+  return (s);
+}
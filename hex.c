@@ -0,0 +1,260 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Hit testing.  pixel_to_hex() turns a point on the
+ **                     map back into the hex drawn there, by inverting the
+ **                     hex_ctr/LINE_INC layout; world_at() finds the world
+ **                     in a hex through a hash on its absolute hex number,
+ **                     so neither depends on how many worlds are loaded.
+ **                     world_info() is the text the inspector shows.
+ **
+ **  File:              hex.c, containing the following subroutines:
+ **                       hex_index_stale()
+ **                       world_at()
+ **                       pixel_to_hex()
+ **                       world_info()
+ **                       loaded_subsector()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+/*-- the hash: open addressing, at most half full, -1 for an empty slot --*/
+static int *slot_world;
+static unsigned slot_mask;
+static int slot_max;
+static int index_valid = FALSE, index_cnt;
+
+#define HEX_KEY(c, r)   ((((unsigned) (c) & 0xffff) << 16) | \
+                                ((unsigned) (r) & 0xffff))
+#define HEX_HASH(k)     (((k) * 2654435761u) >> 8)
+
+/*-- forget the index: the datafile has been read again --*/
+void hex_index_stale()
+{
+  index_valid = FALSE;
+}
+
+/*-- the slot of hex [c, r]: the one holding it, or the empty one it
+     would go in --*/
+static unsigned hex_slot_of(c, r)
+int c, r;
+{
+  unsigned i, key;
+  World *w;
+
+  key = HEX_KEY(c, r);
+  for (i=HEX_HASH(key) & slot_mask; slot_world[i] >= 0; i=(i+1) & slot_mask) {
+    w = &sec_world[slot_world[i]];
+    if (HEX_KEY(w->col, w->row) == key)
+      break;
+   }
+  return (i);
+}
+
+/*-- hash every world on its hex; a later one in the same hex replaces the
+     earlier, as it is drawn over it --*/
+static void hex_index()
+{
+  int i, n;
+
+  for (n=16; n < 2 * w_cnt; n*=2);
+  slot_world = (int *) grow((char *) slot_world, &slot_max, n, sizeof(int));
+  slot_mask = n - 1;
+  for (i=0; i<n; i++)
+    slot_world[i] = -1;
+  for (i=0; i<w_cnt; i++)
+    slot_world[hex_slot_of(sec_world[i].col, sec_world[i].row)] = i;
+  index_cnt = w_cnt;
+  index_valid = TRUE;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  world_at                                                        *
+ *                                                                           *
+ * Purpose:  The index in sec_world of the world in absolute hex [c, r], or  *
+ *           -1 if there is none.  The index is built on the first call      *
+ *           after the data changes.                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+int world_at(c, r)
+int c, r;
+{
+  if (!index_valid || (index_cnt != w_cnt))
+    hex_index();
+  return (slot_world[hex_slot_of(c, r)]);
+}
+
+/*-- TRUE if [dx, dy] from the center of a hex is inside it: the hex is
+     S(60) wide across the middle and S(30) across the top and bottom --*/
+static int in_hex(dx, dy)
+int dx, dy;
+{
+  int half = LINE_INC / 2;
+
+  if (dx < 0) dx = -dx;
+  if (dy < 0) dy = -dy;
+  return ((dy <= half) && (dx * half <= S(60) * half - S(30) * dy));
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  pixel_to_hex                                                    *
+ *                                                                           *
+ * Purpose:  Find the hex of View 'v' drawn at pixel [x, y] of the map (or   *
+ *           of the subsector window, a View of 8x10 hexes) and put its      *
+ *           absolute hex in *c, *r.  The column is worked out from x and    *
+ *           the row from y, then the two columns either side of the point   *
+ *           are tried against the hex outline, so it takes the same time    *
+ *           wherever the point is.  Returns FALSE if the point is on no     *
+ *           hex of the View.                                                *
+ *                                                                           *
+ *****************************************************************************/
+
+int pixel_to_hex(v, x, y, c, r)
+View *v;
+int x, y, *c, *r;
+{
+  int i, col, row, cx, cy, half, best, dist, bc, br;
+
+/*--- measure from the center of hex [v->col, v->row] ---*/
+  half = LINE_INC / 2;
+  x -= hex_ctr[HEX_PAD].x;
+  y -= hex_ctr[HEX_PAD].y + PAD;
+  col = ((x >= 0) ? x / COL_INC : -((-x + COL_INC - 1) / COL_INC)) + v->col;
+  best = -1;
+  for (i=0; i<2; i++, col++) {
+    cx = COL_INC * (col - v->col);
+    cy = y - half * (col & 1) + half;
+    row = ((cy >= 0) ? cy / LINE_INC : -((-cy + LINE_INC - 1) / LINE_INC));
+    cy = half * (col & 1) + LINE_INC * row;
+    row += v->row;
+    if (in_hex(x - cx, y - cy)) {
+      bc = col;
+      br = row;
+      best = 0;
+      break;
+     }
+/*--- on an outline both sides reject: take the nearer center ---*/
+    dist = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+    if ((best < 0) || (dist < best)) {
+      best = dist;
+      bc = col;
+      br = row;
+     }
+   }
+  if ((bc < v->col) || (bc >= v->col + v->cols) ||
+      (br < v->row) || (br >= v->row + v->rows))
+    return (FALSE);
+  *c = bc;
+  *r = br;
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  world_info                                                      *
+ *                                                                           *
+ * Purpose:  Put the inspector's description of world 'w' in 'lines', one   *
+ *           line of at most INFO_WIDTH-1 characters each, and return how    *
+ *           many there are (at most NUM_INFO).                              *
+ *                                                                           *
+ *****************************************************************************/
+
+static char *base_name(b)
+int b;
+{
+  switch (b) {
+    case 'A' : return ("naval and scout");
+    case 'B' : return ("naval and way station");
+    case 'C' : return ("corsair");
+    case 'D' : return ("depot");
+    case 'F' :
+    case 'G' :
+    case 'J' : return ("naval");
+    case 'H' : return ("naval and corsair");
+    case 'M' : return ("military");
+    case 'N' : return ("naval");
+    case 'R' : return ("Aslan");
+    case 'S' : return ("scout");
+    case 'T' : return ("Tlaukhu");
+    case 'W' : return ("way station");
+    case 'Z' : return ("Zhodani");
+   }
+  return ("none");
+}
+
+static char *zone_name(z)
+int z;
+{
+  switch (z) {
+    case 'A' : return ("amber");
+    case 'R' : return ("red");
+   }
+  return ("green");
+}
+
+int world_info(w, lines)
+World *w;
+char lines[NUM_INFO][INFO_WIDTH];
+{
+  char notes[20];
+  int i, k;
+
+  for (i=0, k=0; w->notes[i] && w->notes[i+1]; i+=2) {
+    if (k) notes[k++] = ' ';
+    notes[k++] = w->notes[i];
+    notes[k++] = w->notes[i+1];
+   }
+  notes[k] = '\0';
+  sprintf(lines[0], "%.20s  %.4s", w->name[0] ? w->name : "(unnamed)",
+                w->hex);
+  sprintf(lines[1], "UWP         %.9s", w->uwp);
+  sprintf(lines[2], "Bases       %c  %s", w->Base[0] ? w->Base[0] : '-',
+                base_name(w->Base[0]));
+  sprintf(lines[3], "Notes       %s", k ? notes : "-");
+  sprintf(lines[4], "PBG         %.3s", w->pbg[0] ? w->pbg : "-");
+  sprintf(lines[5], "Allegiance  %.2s", w->allegiance[0] ? w->allegiance : "-");
+  sprintf(lines[6], "Zone        %s", zone_name(w->Zone[0]));
+  return (NUM_INFO);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  loaded_subsector                                                *
+ *                                                                           *
+ * Purpose:  Set 'v' to the 8x10 hexes of the subsector the worlds loaded    *
+ *           are folded into by gen_sector(), taken to be that of the last   *
+ *           world read (the one drawn on top).  Returns FALSE if there are  *
+ *           no worlds.                                                      *
+ *                                                                           *
+ *****************************************************************************/
+
+int loaded_subsector(v)
+View *v;
+{
+  World *w;
+
+  if (w_cnt == 0)
+    return (FALSE);
+  w = &sec_world[w_cnt-1];
+  v->col = w->col - w->location.x;
+  v->row = w->row - w->location.y;
+  v->cols = NUM_HEXES;
+  v->rows = NUM_LINES;
+  return (TRUE);
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       World label layout.  Where each label of a world
+ **                     goes (hex number, allegiance, trade codes, name and
+ **                     UWP), how long it is and which font it is set in
+ **                     depend only on the world and on the device's fonts,
+ **                     so they are worked out for every world in one pass
+ **                     after the datafile is read and kept;
+ **                     draw_world_parts() only sends the text.  The
+ **                     positions are kept as offsets from the center of the
+ **                     hex, as the same world is drawn in different places
+ **                     on the subsector and the sector maps.
+ **
+ **  File:              label.c, containing the following subroutines:
+ **                       label_stale()
+ **                       label_layout()
+ **                       world_label()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+static Label *label;
+static int label_max, label_cnt;
+static int label_valid = FALSE;
+
+/*-- what the layout was made for: a device's width routine stands for its
+     fonts, and the Geometry for the scale --*/
+static int (*label_width)();
+static Geometry *label_geom;
+
+/*-- forget the layout: the datafile has been read again --*/
+void label_stale()
+{
+  label_valid = FALSE;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  label_layout                                                    *
+ *                                                                           *
+ * Purpose:  Lay out the labels of every world in sec_world for the fonts of *
+ *           Device 'dev' at the current scale, unless that is what was done *
+ *           last.  gen_map_threads() calls it before its threads start.     *
+ *                                                                           *
+ *****************************************************************************/
+
+void label_layout(dev)
+Device *dev;
+{
+  int i, len;
+  World *w;
+  Label *l;
+
+  if (label_valid && (label_cnt == w_cnt) && (label_width == dev->width) &&
+      (label_geom == geom))
+    return;
+  label = (Label *) grow((char *) label, &label_max, w_cnt, sizeof(Label));
+  for (i=0; i<w_cnt; i++) {
+    w = &sec_world[i];
+    l = &label[i];
+    len = (*dev->width)(dev, FONT_NORMAL, w->hex, 4);
+    l->hex_x = -(len/2);
+    len = (*dev->width)(dev, FONT_NORMAL, w->allegiance, 2);
+    l->alleg_x = -S(30) - (len/2);
+    l->notes_len = strlen(w->notes);
+    len = (*dev->width)(dev, FONT_NORMAL, w->notes, l->notes_len);
+    l->notes_x = S(25) - (len/2);
+    l->name_len = strlen(w->name);
+    l->name_font = (w->uwp[3] >= '9') ? FONT_BOLD : FONT_NORMAL;
+    len = (*dev->width)(dev, l->name_font, w->name, l->name_len);
+    l->name_x = -(len/2);
+    l->uwp_len = strlen(w->uwp);
+    len = (*dev->width)(dev, FONT_SMALL, w->uwp, l->uwp_len);
+    l->uwp_x = -(len/2);
+   }
+  label_cnt = w_cnt;
+  label_width = dev->width;
+  label_geom = geom;
+  label_valid = TRUE;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  world_label                                                     *
+ *                                                                           *
+ * Purpose:  The label layout of world 'w', which must be in sec_world, for  *
+ *           Device 'dev'.                                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+Label *world_label(dev, w)
+Device *dev;
+World *w;
+{
+  label_layout(dev);
+  return (&label[w - sec_world]);
+}
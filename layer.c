@@ -0,0 +1,315 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Retained layers for the X map window.  The map is
+ **                     kept in the server as a stack of offscreen pixmaps,
+ **                     each a copy of the one below it with one more step of
+ **                     gen_sector() drawn on top: the routes and grid, then
+ **                     the zone borders, then the world symbols.  The three
+ **                     label layers (allegiance, trade codes and UWP) are
+ **                     kept apart, each with a mask of the text it covers,
+ **                     and are composited over the world layer.  A button
+ **                     toggle or an Expose is then a copy and a few masked
+ **                     copies; only a layer whose contents changed is drawn
+ **                     again.  Each layer remembers which parts of it are
+ **                     out of date, so an Expose repairs only the damaged
+ **                     rectangles, drawing only the items damage.c finds in
+ **                     them.
+ **
+ **  File:              layer.c, containing the following subroutines:
+ **                       layer_invalidate()
+ **                       layer_stale_area()
+ **                       layer_damage()
+ **                       layer_repair()
+ **                       layer_show()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+#define  NUM_LABELS  3
+
+static int label_part[NUM_LABELS] = { WORLD_ALLEGIANCE, WORLD_TRADE,
+                                      WORLD_UWP };
+
+#define  MAX_DAMAGE  16
+
+static Pixmap layer_pix[NUM_LAYERS];
+static Region layer_dirty[NUM_LAYERS];      /* what is out of date in each */
+
+static Pixmap label_pix[NUM_LABELS], label_mask[NUM_LABELS];
+static Region label_dirty[NUM_LABELS];
+
+static XRectangle damage[MAX_DAMAGE];       /* the window areas to repair  */
+static int damage_cnt = 0;
+
+static GC layer_gc;
+
+/*-- mark all of 'r' out of date, creating it if need be --*/
+static Region dirty_all(r)
+Region r;
+{
+  XRectangle all;
+
+  if (r != NULL)
+    XDestroyRegion(r);
+  r = XCreateRegion();
+  all.x = 0;
+  all.y = 0;
+  all.width = MAP_WIDTH;
+  all.height = MAP_HEIGHT;
+  XUnionRectWithRegion(&all, r, r);
+  return (r);
+}
+
+/*-- TRUE if any of area 'a' of region 'r' is out of date; it is then taken
+     out of 'r', as the caller is about to draw it --*/
+static int take_dirty(r, a)
+Region r;
+XRectangle *a;
+{
+  Region t;
+
+  if (XRectInRegion(r, a->x, a->y, a->width, a->height) == RectangleOut)
+    return (FALSE);
+  t = XCreateRegion();
+  XUnionRectWithRegion(a, t, t);
+  XSubtractRegion(r, t, r);
+  XDestroyRegion(t);
+  return (TRUE);
+}
+
+static int whole_map(a)
+XRectangle *a;
+{
+  return ((a->x == 0) && (a->y == 0) &&
+          (a->width == MAP_WIDTH) && (a->height == MAP_HEIGHT));
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  layer_invalidate                                                *
+ *                                                                           *
+ * Purpose:  Mark 'layer' and everything stacked on it as out of date, so    *
+ *           the next repaint draws them again.  LAYER_GRID (a new datafile) *
+ *           takes the label layers with it; LAYER_BORDERS is for a border   *
+ *           marked or cleared.                                              *
+ *                                                                           *
+ *****************************************************************************/
+
+void layer_invalidate(layer)
+int layer;
+{
+  int i;
+
+  for (i=layer; i<NUM_LAYERS; i++)
+    layer_dirty[i] = dirty_all(layer_dirty[i]);
+  if (layer == LAYER_GRID)
+    for (i=0; i<NUM_LABELS; i++)
+      label_dirty[i] = dirty_all(label_dirty[i]);
+  sector_index_stale();
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  layer_stale_area                                                *
+ *                                                                           *
+ * Purpose:  Mark one area of every layer out of date, after the items drawn *
+ *           there have changed (watch.c), and note it for the next          *
+ *           layer_repair().  The rest of the layers are kept.               *
+ *                                                                           *
+ *****************************************************************************/
+
+void layer_stale_area(x, y, width, height)
+int x, y, width, height;
+{
+  XRectangle a;
+  int i;
+
+  sector_index_stale();
+  layer_damage(x, y, width, height);
+  if (layer_gc == NULL)
+    return;
+  a.x = x;
+  a.y = y;
+  a.width = width;
+  a.height = height;
+  for (i=0; i<NUM_LAYERS; i++)
+    XUnionRectWithRegion(&a, layer_dirty[i], layer_dirty[i]);
+  for (i=0; i<NUM_LABELS; i++)
+    XUnionRectWithRegion(&a, label_dirty[i], label_dirty[i]);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  layer_build                                                     *
+ *                                                                           *
+ * Purpose:  Bring area 'a' of the stacked layers up to date, from the       *
+ *           lowest up: each layer is a copy of the one below it with its    *
+ *           own step of gen_sector() drawn on top.  Unless 'a' is the whole *
+ *           map, the drawing is clipped to it and only the items that meet  *
+ *           it are drawn (sector_area).                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+static void layer_build(a)
+XRectangle *a;
+{
+  Device *dev;
+  int l, whole;
+
+  if (layer_gc == NULL) {
+    layer_gc = XCreateGC(dpy, win, 0, 0);
+    layer_invalidate(LAYER_GRID);
+   }
+  whole = whole_map(a);
+  for (l=0; l<NUM_LAYERS; l++) {
+    if (!take_dirty(layer_dirty[l], a))
+      continue;
+    if (layer_pix[l] == None)
+      layer_pix[l] = XCreatePixmap(dpy, win, MAP_WIDTH, MAP_HEIGHT, ScrDepth);
+    sector_area = whole ? NULL : a;
+    x_set_clip(sector_area);
+    dev = x_device(layer_pix[l]);
+    if (l == LAYER_GRID)
+      (*dev->fill_rect)(dev, PAPER, a->x, a->y, a->width, a->height);
+    else
+      XCopyArea(dpy, layer_pix[l-1], layer_pix[l], layer_gc, a->x, a->y,
+                a->width, a->height, a->x, a->y);
+    switch (l) {
+      case LAYER_GRID    : gen_sector_grid(dev);
+                           break;
+      case LAYER_BORDERS : gen_sector_borders(dev);
+                           break;
+      case LAYER_WORLDS  : gen_sector_worlds(dev, WORLD_SYMBOL);
+                           break;
+     }
+    x_set_clip(NULL);
+    sector_area = NULL;
+   }
+}
+
+/*-- bring area 'a' of label layer 'i' and of its mask up to date --*/
+static void label_build(i, a)
+int i;
+XRectangle *a;
+{
+  if (!take_dirty(label_dirty[i], a))
+    return;
+  if (label_pix[i] == None) {
+    label_pix[i] = XCreatePixmap(dpy, win, MAP_WIDTH, MAP_HEIGHT, ScrDepth);
+    label_mask[i] = XCreatePixmap(dpy, win, MAP_WIDTH, MAP_HEIGHT, 1);
+   }
+  sector_area = whole_map(a) ? NULL : a;
+  x_set_clip(sector_area);
+  gen_sector_worlds(x_layer_device(label_pix[i], label_mask[i]),
+                label_part[i]);
+  x_set_clip(NULL);
+  sector_area = NULL;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: layer_damage, layer_repair                                      *
+ *                                                                           *
+ * Purpose:  layer_damage() notes an area of the map window (an Expose       *
+ *           rectangle) that needs painting; layer_repair() paints them all  *
+ *           on drawable 'd', with the labels in 'parts' (WORLD_ALLEGIANCE,  *
+ *           etc.) composited over the world symbols.  Only the out of date  *
+ *           parts of the layers under each area are drawn; the rest is      *
+ *           copied from the server's own memory.  Past MAX_DAMAGE areas,    *
+ *           their bounding box is repaired instead.  With '-r' the number   *
+ *           of X requests each repair took is reported on stderr.           *
+ *                                                                           *
+ *****************************************************************************/
+
+void layer_damage(x, y, width, height)
+int x, y, width, height;
+{
+  XRectangle *d;
+  int x2, y2;
+
+  if (x < 0) { width += x;  x = 0; }
+  if (y < 0) { height += y; y = 0; }
+  if (x + width > MAP_WIDTH)   width = MAP_WIDTH - x;
+  if (y + height > MAP_HEIGHT) height = MAP_HEIGHT - y;
+  if ((width <= 0) || (height <= 0))
+    return;
+  if (damage_cnt < MAX_DAMAGE) {
+    d = &damage[damage_cnt++];
+    d->x = x;
+    d->y = y;
+    d->width = width;
+    d->height = height;
+    return;
+   }
+  d = &damage[MAX_DAMAGE-1];
+  x2 = ((d->x + d->width) > (x + width)) ? d->x + d->width : x + width;
+  y2 = ((d->y + d->height) > (y + height)) ? d->y + d->height : y + height;
+  if (x < d->x) d->x = x;
+  if (y < d->y) d->y = y;
+  d->width = x2 - d->x;
+  d->height = y2 - d->y;
+}
+
+void layer_repair(d, parts)
+Drawable d;
+int parts;
+{
+  int i, j;
+  unsigned long first;
+  XRectangle *a;
+
+  first = NextRequest(dpy);
+  for (j=0; j<damage_cnt; j++) {
+    a = &damage[j];
+    layer_build(a);
+    XCopyArea(dpy, layer_pix[LAYER_WORLDS], d, layer_gc, a->x, a->y,
+                a->width, a->height, a->x, a->y);
+    for (i=0; i<NUM_LABELS; i++) {
+      if (!(parts & label_part[i]))
+        continue;
+      label_build(i, a);
+      XSetClipMask(dpy, layer_gc, label_mask[i]);
+      XCopyArea(dpy, label_pix[i], d, layer_gc, a->x, a->y,
+                a->width, a->height, a->x, a->y);
+      XSetClipMask(dpy, layer_gc, None);
+     }
+   }
+  damage_cnt = 0;
+  XFlush(dpy);
+  stats_flushes++;
+  if (frame_stats)
+    fprintf(stderr, "%s: frame: %lu X requests\n", program_name,
+                NextRequest(dpy) - first);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  layer_show                                                      *
+ *                                                                           *
+ * Purpose:  Put the whole map on drawable 'd' (the map window or a pixmap   *
+ *           of the same size), with the labels in 'parts'.                  *
+ *                                                                           *
+ *****************************************************************************/
+
+void layer_show(d, parts)
+Drawable d;
+int parts;
+{
+  damage_cnt = 0;
+  layer_damage(0, 0, MAP_WIDTH, MAP_HEIGHT);
+  layer_repair(d, parts);
+}
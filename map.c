@@ -0,0 +1,656 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Sector and multi-sector maps.  gen_map() draws any
+ **                     rectangle of hexes (a View) out of one or more loaded
+ **                     sectors, using the absolute hex coordinates that
+ **                     read_sector_file() records.  Worlds and border edges
+ **                     are indexed by hex and routes by subsector-sized
+ **                     cell, so only what falls inside the View is visited:
+ **                     the cost of a map depends on its area, not on how
+ **                     much data is loaded.
+ **
+ **  File:              map.c, containing the following subroutines:
+ **                       map_extent()
+ **                       map_index()
+ **                       map_view_size()
+ **                       gen_map()
+ **                       gen_map_threads()
+ **                       map_load()
+ **                       map_print()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <unistd.h>
+#include <limits.h>
+#include <pthread.h>
+
+/*****************************************************************************
+ **
+ **  Hex [c, r] of a View is centered on [MAP_X, MAP_Y+PAD].  This is the
+ **  hex_ctr[] layout of gen_sector() carried on indefinitely: even columns
+ **  (01, 03, ...) sit half a hex higher than odd ones.
+ **
+ *****************************************************************************/
+
+#define MAP_X(v, c)     (hex_ctr[HEX_PAD].x + COL_INC * ((c) - (v)->col))
+#define MAP_Y(v, c, r)  (hex_ctr[HEX_PAD].y + LINE_INC / 2 * ((c) & 1) + \
+                                LINE_INC * ((r) - (v)->row))
+
+#define CELL_COLS   NUM_HEXES
+#define CELL_ROWS   NUM_LINES
+
+#define BANDS_PER_THREAD  4
+
+/*-- the loaded area, in absolute hexes, and the indexes over it --*/
+static View map;
+static int cells_x, cells_y;
+static int *hex_world;                 /* world index per hex, or -1       */
+static int *bdr_first, *bdr_list;      /* file_bdr indices per hex         */
+static int *cell_first, *cell_list;    /* t_route indices per cell         */
+static int *route_mark, mark_gen;      /* routes already drawn this frame */
+
+/*-- floor division, so hexes left of or above the map land in cell -1 --*/
+static int fdiv(a, b)
+int a, b;
+{
+  return ((a >= 0) ? a / b : -((-a + b - 1) / b));
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  map_extent                                                      *
+ *                                                                           *
+ * Purpose:  Set the loaded area to the sectors [sx0..sx1] x [sy0..sy1].     *
+ *                                                                           *
+ *****************************************************************************/
+
+void map_extent(sx0, sy0, sx1, sy1)
+int sx0, sy0, sx1, sy1;
+{
+  map.col = sx0 * SECTOR_COLS;
+  map.row = sy0 * SECTOR_ROWS;
+  map.cols = (sx1 - sx0 + 1) * SECTOR_COLS;
+  map.rows = (sy1 - sy0 + 1) * SECTOR_ROWS;
+}
+
+/*-- index of hex [c, r] in the per-hex arrays, or -1 if off the map --*/
+static int hex_slot(c, r)
+int c, r;
+{
+  if ((c < map.col) || (c >= map.col + map.cols) ||
+      (r < map.row) || (r >= map.row + map.rows))
+    return (-1);
+  return ((r - map.row) * map.cols + (c - map.col));
+}
+
+static int *int_array(n)
+int n;
+{
+  int *p;
+
+  if ((p = (int *) calloc(n > 0 ? n : 1, sizeof(int))) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", program_name);
+    exit(1); }
+  return (p);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  map_index                                                       *
+ *                                                                           *
+ * Purpose:  Build the hex and cell indexes over sec_world, file_bdr and     *
+ *           t_route.  Must be called after the last read_sector_file().     *
+ *           Both lists are counting-sorted: X_first[k]..X_first[k+1]-1 are  *
+ *           the positions in X_list belonging to hex or cell k.             *
+ *                                                                           *
+ *****************************************************************************/
+
+void map_index()
+{
+  int i, k, n, cx, cy, cx0, cx1, cy0, cy1, lo, hi, pass;
+
+  free(hex_world);  free(bdr_first);  free(bdr_list);
+  free(cell_first); free(cell_list);  free(route_mark);
+
+  n = map.cols * map.rows;
+  hex_world = int_array(n);
+  for (k=0; k<n; k++)
+    hex_world[k] = -1;
+  for (i=0; i<w_cnt; i++)
+    if ((k = hex_slot(sec_world[i].col, sec_world[i].row)) >= 0)
+      hex_world[k] = i;
+
+  bdr_first = int_array(n + 1);
+  bdr_list = int_array(private_bdr_cnt);
+  for (i=0; i<private_bdr_cnt; i++)
+    if ((k = hex_slot(file_bdr[i].col, file_bdr[i].row)) >= 0)
+      bdr_first[k+1]++;
+  for (k=0; k<n; k++)
+    bdr_first[k+1] += bdr_first[k];
+  for (i=0; i<private_bdr_cnt; i++)
+    if ((k = hex_slot(file_bdr[i].col, file_bdr[i].row)) >= 0)
+      bdr_list[bdr_first[k]++] = i;
+  for (k=n; k>0; k--)
+    bdr_first[k] = bdr_first[k-1];
+  bdr_first[0] = 0;
+
+/*--- a route goes in every cell its bounding box touches; 1st pass counts ---*/
+  cells_x = fdiv(map.cols + CELL_COLS - 1, CELL_COLS);
+  cells_y = fdiv(map.rows + CELL_ROWS - 1, CELL_ROWS);
+  cell_first = int_array(cells_x * cells_y + 1);
+  route_mark = int_array(tr_cnt);
+  mark_gen = 0;
+  cell_list = NULL;
+  for (pass=0; pass<2; pass++) {
+    for (i=0; i<tr_cnt; i++) {
+      lo = (t_route[i].c1 < t_route[i].c2) ? t_route[i].c1 : t_route[i].c2;
+      hi = (t_route[i].c1 < t_route[i].c2) ? t_route[i].c2 : t_route[i].c1;
+      cx0 = fdiv(lo - map.col, CELL_COLS);
+      cx1 = fdiv(hi - map.col, CELL_COLS);
+      lo = (t_route[i].r1 < t_route[i].r2) ? t_route[i].r1 : t_route[i].r2;
+      hi = (t_route[i].r1 < t_route[i].r2) ? t_route[i].r2 : t_route[i].r1;
+      cy0 = fdiv(lo - map.row, CELL_ROWS);
+      cy1 = fdiv(hi - map.row, CELL_ROWS);
+      if (cx0 < 0) cx0 = 0;
+      if (cy0 < 0) cy0 = 0;
+      if (cx1 >= cells_x) cx1 = cells_x - 1;
+      if (cy1 >= cells_y) cy1 = cells_y - 1;
+      for (cy=cy0; cy<=cy1; cy++)
+        for (cx=cx0; cx<=cx1; cx++) {
+          k = cy * cells_x + cx;
+          if (pass == 0)
+            cell_first[k+1]++;
+          else
+            cell_list[cell_first[k]++] = i;
+         }
+     }
+    if (pass == 0) {
+      for (k=0; k<cells_x*cells_y; k++)
+        cell_first[k+1] += cell_first[k];
+      cell_list = int_array(cell_first[cells_x*cells_y]);
+     }
+   }
+  for (k=cells_x*cells_y; k>0; k--)
+    cell_first[k] = cell_first[k-1];
+  cell_first[0] = 0;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  map_view_size                                                   *
+ *                                                                           *
+ * Purpose:  The pixel size of a View, laid out as gen_sector() lays out a   *
+ *           subsector: an 8x10 View is exactly MAP_WIDTH x MAP_HEIGHT.      *
+ *                                                                           *
+ *****************************************************************************/
+
+void map_view_size(v, width, height)
+View *v;
+int *width, *height;
+{
+  *width = v->cols * COL_INC + S(50);
+  *height = v->rows * LINE_INC + S(70) + PAD;
+}
+
+/*****************************************************************************
+ **
+ **  To draw on several threads, the View is cut into horizontal bands
+ **  band_h pixels high.  map_bin() lists, for each band, the routes,
+ **  border edges and worlds that can draw on it, in the order gen_map()
+ **  draws them; the items of one kind on band k are
+ **  bin_list[kind][bin_first[kind][k]..bin_first[kind][k+1]-1].  With a
+ **  single band this is the list of everything gen_map() draws.
+ **
+ *****************************************************************************/
+
+#define BIN_ROUTE   0
+#define BIN_BORDER  1
+#define BIN_WORLD   2
+#define NUM_BINS    3
+
+/*-- an item that may be drawn, and the pixel rows it can draw on --*/
+typedef struct _binitem {
+        int item, y1, y2;
+        } BinItem;
+
+static int band_cnt, band_h;
+static int *bin_first[NUM_BINS], *bin_list[NUM_BINS], list_max[NUM_BINS];
+static BinItem *cand;
+static int cand_cnt, cand_max;
+
+static void add_cand(item, y1, y2)
+int item, y1, y2;
+{
+  cand = (BinItem *) grow((char *) cand, &cand_max, cand_cnt,
+                sizeof(BinItem));
+  cand[cand_cnt].item = item;
+  cand[cand_cnt].y1 = y1;
+  cand[cand_cnt++].y2 = y2;
+}
+
+/*-- the bands rows y1..y2 fall in, clipped to the View --*/
+static void band_range(y1, y2, b1, b2)
+int y1, y2, *b1, *b2;
+{
+  *b1 = fdiv(y1, band_h);
+  *b2 = fdiv(y2, band_h);
+  if (*b1 < 0) *b1 = 0;
+  if (*b2 >= band_cnt) *b2 = band_cnt - 1;
+}
+
+/*-- counting-sort the candidates into the bands of bin 'kind' --*/
+static void bin_cands(kind)
+int kind;
+{
+  int i, k, b1, b2, pass, n;
+  int *first, *list;
+
+  free(bin_first[kind]);
+  first = bin_first[kind] = int_array(band_cnt + 1);
+  list = bin_list[kind];
+  n = 0;
+  for (pass=0; pass<2; pass++) {
+    for (i=0; i<cand_cnt; i++) {
+      band_range(cand[i].y1, cand[i].y2, &b1, &b2);
+      for (k=b1; k<=b2; k++)
+        if (pass == 0)
+          first[k+1]++;
+        else
+          list[first[k]++] = cand[i].item;
+     }
+    if (pass == 0) {
+      for (k=0; k<band_cnt; k++)
+        first[k+1] += first[k];
+      n = first[band_cnt];
+      list = bin_list[kind] = (int *) grow((char *) bin_list[kind],
+                &list_max[kind], n, sizeof(int));
+     }
+   }
+  for (k=band_cnt; k>0; k--)
+    first[k] = first[k-1];
+  first[0] = 0;
+  cand_cnt = 0;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  map_bin                                                         *
+ *                                                                           *
+ * Purpose:  Cut View 'v' into bands 'height' pixels high and bin what       *
+ *           gen_map() draws by band.  Only the hexes (or route cells)       *
+ *           inside the View, widened by one hex so that routes and borders  *
+ *           crossing its edge are still drawn, are looked at.  Each item's  *
+ *           rows are a little generous (a wide pen, the labels of a world); *
+ *           an item binned in a band it misses is only clipped away.        *
+ *                                                                           *
+ *****************************************************************************/
+
+static void map_bin(v, height)
+View *v;
+int height;
+{
+  int c, r, i, k, cx, cy, y1, y2, t, c0, c1, r0, r1, width, map_h, reach;
+  Route *rt;
+
+  map_view_size(v, &width, &map_h);
+  band_h = (height > 0) ? height : 1;
+  band_cnt = (map_h + band_h - 1) / band_h;
+  if (band_cnt < 1) band_cnt = 1;
+  c0 = v->col - 1;  c1 = v->col + v->cols;
+  r0 = v->row - 1;  r1 = v->row + v->rows;
+
+/*--- the routes that may cross the View, found by cell ---*/
+  mark_gen++;
+  for (cy=fdiv(r0 - map.row, CELL_ROWS); cy<=fdiv(r1 - map.row, CELL_ROWS); cy++) {
+    if ((cy < 0) || (cy >= cells_y)) continue;
+    for (cx=fdiv(c0 - map.col, CELL_COLS); cx<=fdiv(c1 - map.col, CELL_COLS); cx++) {
+      if ((cx < 0) || (cx >= cells_x)) continue;
+      k = cy * cells_x + cx;
+      for (i=cell_first[k]; i<cell_first[k+1]; i++) {
+        if (route_mark[cell_list[i]] == mark_gen) continue;
+        route_mark[cell_list[i]] = mark_gen;
+        rt = &t_route[cell_list[i]];
+        if ((rt->c1 < c0 && rt->c2 < c0) || (rt->c1 > c1 && rt->c2 > c1) ||
+            (rt->r1 < r0 && rt->r2 < r0) || (rt->r1 > r1 && rt->r2 > r1))
+          continue;
+        y1 = MAP_Y(v, rt->c1, rt->r1) + PAD;
+        y2 = MAP_Y(v, rt->c2, rt->r2) + PAD;
+        if (y1 > y2) { t = y1; y1 = y2; y2 = t; }
+        add_cand(cell_list[i], y1 - S(5), y2 + S(5));
+       }
+     }
+   }
+  bin_cands(BIN_ROUTE);
+
+/*--- the border edges of the hexes in (and just around) the View ---*/
+  for (r=r0; r<=r1; r++)
+    for (c=c0; c<=c1; c++) {
+      if ((k = hex_slot(c, r)) < 0) continue;
+      y1 = MAP_Y(v, c, r) - LINE_INC / 2 + PAD;
+      for (i=bdr_first[k]; i<bdr_first[k+1]; i++)
+        add_cand(bdr_list[i], y1 - S(5), y1 + LINE_INC + S(5));
+     }
+  bin_cands(BIN_BORDER);
+
+/*--- the worlds in the View, from the top row down ---*/
+  reach = LINE_INC / 2 + S(10);
+  for (r=v->row; r<v->row+v->rows; r++)
+    for (c=v->col; c<v->col+v->cols; c++)
+      if (((k = hex_slot(c, r)) >= 0) && (hex_world[k] >= 0)) {
+        y1 = MAP_Y(v, c, r) + PAD;
+        add_cand(hex_world[k], y1 - reach, y1 + reach);
+       }
+  bin_cands(BIN_WORLD);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  gen_map_band                                                    *
+ *                                                                           *
+ * Purpose:  Draw band 'band' of View 'v' (as binned by map_bin) in the four *
+ *           steps gen_sector() uses: routes, grid, borders, systems.  The   *
+ *           device should only draw on the band's rows (raster_band); the   *
+ *           items each step draws are those binned on the band, and the    *
+ *           hex grid only the rows of hexes that reach it.                  *
+ *                                                                           *
+ *****************************************************************************/
+
+static void gen_map_band(dev, v, band)
+Device *dev;
+View *v;
+int band;
+{
+  int c, r, i, k, width, height, len, x, y, top;
+  XPoint pts[NUM_HEX_PTS];
+  XSegment seg;
+  Border *b;
+  Route *rt;
+  World *w;
+
+  map_view_size(v, &width, &height);
+
+/*--- Step 1: generate the trade-routes that may cross the band ---*/
+  (*dev->pen)(dev, S(5), CapRound, FillSolid);
+  for (i=bin_first[BIN_ROUTE][band]; i<bin_first[BIN_ROUTE][band+1]; i++) {
+    rt = &t_route[bin_list[BIN_ROUTE][i]];
+    (*dev->line)(dev, MAP_X(v, rt->c1), MAP_Y(v, rt->c1, rt->r1)+PAD,
+                      MAP_X(v, rt->c2), MAP_Y(v, rt->c2, rt->r2)+PAD);
+   }
+  (*dev->flush)(dev);
+  (*dev->pen)(dev, 1, CapButt, FillSolid);
+
+/*--- Step 2: generate the empty grid ---*/
+  (*dev->fill_rect)(dev, PAPER, 0, 0, width, S(10)+PAD);
+  (*dev->fill_rect)(dev, PAPER, 0, 0, S(10), height);
+  (*dev->fill_rect)(dev, PAPER, 0, height-S(10), width, S(10));
+  (*dev->fill_rect)(dev, PAPER, width-S(10), 0, S(10), height);
+  (*dev->pen)(dev, 0, CapButt, FillSolid);
+  for (k=0; k<NUM_HEX_PTS; k++)
+    pts[k] = hex_pts[k];
+  for (r=v->row; r<v->row+v->rows; r++) {
+    top = hex_ctr[HEX_PAD].y + LINE_INC * (r - v->row) - LINE_INC / 2 + PAD;
+    if ((top + LINE_INC * 3 / 2 < band * band_h) ||
+        (top > (band + 1) * band_h))
+      continue;
+    for (c=v->col; c<v->col+v->cols; c++) {
+      pts[0].x = MAP_X(v, c) - S(30);
+      pts[0].y = MAP_Y(v, c, r) - LINE_INC / 2 + PAD;
+      (*dev->lines)(dev, pts, NUM_HEX_PTS, CoordModePrevious);
+     }
+   }
+/*--- close off the half hexes cut by the frame at the 4 corners ---*/
+  c = v->col + v->cols - 1;
+  if (c & 1)
+    (*dev->line)(dev, MAP_X(v, c)+S(30), S(60)+PAD, MAP_X(v, c)+S(60),
+                S(10)+PAD);
+  else
+    (*dev->line)(dev, MAP_X(v, c)+S(30), height-S(60), MAP_X(v, c)+S(60),
+                height-S(10));
+  if (v->col & 1)
+    (*dev->line)(dev, S(40), S(60)+PAD, S(10), S(10)+PAD);
+  else
+    (*dev->line)(dev, S(40), height-S(60), S(10), height-S(10));
+  (*dev->pen)(dev, S(3), CapButt, FillSolid);
+  (*dev->draw_rect)(dev, S(10), S(10)+PAD, width-2*S(10),
+                height-2*S(10)-PAD);
+  (*dev->pen)(dev, 1, CapButt, FillSolid);
+  if ((len = strlen(title)) > 0) {
+    if (title[len-1] == '\n') len--;
+    x = (*dev->width)(dev, FONT_NORMAL, title, len);
+    (*dev->font)(dev, FONT_BOLD);
+    (*dev->text)(dev, (width-x)/2, S(16), title, len);
+    (*dev->font)(dev, FONT_NORMAL);
+   }
+  (*dev->flush)(dev);
+
+/*--- Step 3: border edges of the hexes in (and just around) the View ---*/
+  if (private_bdr_cnt) {
+    (*dev->pen)(dev, S(5), CapButt, FillTiled);
+    for (i=bin_first[BIN_BORDER][band]; i<bin_first[BIN_BORDER][band+1]; i++) {
+      b = &file_bdr[bin_list[BIN_BORDER][i]];
+      x = MAP_X(v, b->col) - S(30);
+      y = MAP_Y(v, b->col, b->row) - LINE_INC / 2 + PAD;
+      seg.x1 = x + abs_hex_pts[b->edge].x;
+      seg.y1 = y + abs_hex_pts[b->edge].y;
+      seg.x2 = x + abs_hex_pts[(b->edge + 1) % 6].x;
+      seg.y2 = y + abs_hex_pts[(b->edge + 1) % 6].y;
+      (*dev->segments)(dev, &seg, 1);
+     }
+    (*dev->pen)(dev, 1, CapButt, FillSolid);
+   }
+
+/*--- Step 4: generate each system on the band ---*/
+  for (i=bin_first[BIN_WORLD][band]; i<bin_first[BIN_WORLD][band+1]; i++) {
+    w = &sec_world[bin_list[BIN_WORLD][i]];
+    draw_world(dev, w, MAP_X(v, w->col), MAP_Y(v, w->col, w->row));
+   }
+  (*dev->flush)(dev);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  gen_map                                                         *
+ *                                                                           *
+ * Purpose:  Draw View 'v' on 'dev', as a single band.                       *
+ *                                                                           *
+ *****************************************************************************/
+
+void gen_map(dev, v)
+Device *dev;
+View *v;
+{
+  int width, height;
+
+  map_view_size(v, &width, &height);
+  map_bin(v, height);
+  gen_map_band(dev, v, 0);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  gen_map_threads                                                 *
+ *                                                                           *
+ * Purpose:  Draw View 'v' on raster Device 'dev' with 'nthreads' threads.   *
+ *           The View is cut into a few bands per thread, each thread taking *
+ *           the next band not yet drawn until there are none left; as every *
+ *           band draws the items on it in gen_map()'s order, the picture is *
+ *           the same as gen_map() draws.  If a thread cannot be started,    *
+ *           the bands it would have drawn are drawn here.                   *
+ *                                                                           *
+ *****************************************************************************/
+
+static pthread_mutex_t band_lock = PTHREAD_MUTEX_INITIALIZER;
+static int band_next;
+static Device *band_dev;
+static View *band_view;
+
+static void *band_worker(arg)
+void *arg;
+{
+  Device *dev;
+  int k;
+
+  for (;;) {
+    pthread_mutex_lock(&band_lock);
+    k = band_next++;
+    pthread_mutex_unlock(&band_lock);
+    if (k >= band_cnt)
+      break;
+    if ((dev = raster_band(band_dev, k * band_h, (k + 1) * band_h)) == NULL) {
+      fprintf(stderr, "%s: Out of memory\n", program_name);
+      exit(1); }
+    gen_map_band(dev, band_view, k);
+    raster_free(dev);
+   }
+  return (NULL);
+}
+
+static void gen_map_threads(dev, v, nthreads)
+Device *dev;
+View *v;
+int nthreads;
+{
+  pthread_t *tid;
+  int i, f, cell, ascent, descent, width, height, bands, started;
+
+/*--- fonts, symbols and labels are made on first use: make them now ---*/
+  for (f=0; f<NUM_FONTS; f++)
+    raster_font_size(f, &cell, &ascent, &descent);
+  for (i=0; i<NUM_SYMS; i++)
+    scaled_symbol(i);
+  label_layout(dev);
+
+  map_view_size(v, &width, &height);
+  bands = nthreads * BANDS_PER_THREAD;
+  map_bin(v, ((height + bands - 1) / bands > LINE_INC) ?
+                (height + bands - 1) / bands : LINE_INC);
+  band_next = 0;
+  band_dev = dev;
+  band_view = v;
+  if ((tid = (pthread_t *) malloc(nthreads * sizeof(pthread_t))) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", program_name);
+    exit(1); }
+  for (started=0; started<nthreads; started++)
+    if (pthread_create(&tid[started], NULL, band_worker, NULL) != 0)
+      break;
+  if (started < nthreads)
+    band_worker(NULL);
+  for (i=0; i<started; i++)
+    pthread_join(tid[i], NULL);
+  free(tid);
+}
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  map_load                                                        *
+ *                                                                           *
+ * Purpose:  Load 'nfiles' sector datafiles, each named 'file' or            *
+ *           'file@sx,sy' to place it at [sx, sy] in the grid of sectors     *
+ *           (default [0, 0]), make the loaded area the rectangle of sectors *
+ *           they cover and index it.  Returns FALSE if a file cannot be     *
+ *           read.                                                           *
+ *                                                                           *
+ *****************************************************************************/
+
+int map_load(nfiles, files)
+int nfiles;
+char **files;
+{
+  int i, sx, sy, sx0, sy0, sx1, sy1;
+  char name[1024], *at;
+
+  w_cnt = tr_cnt = bdr_cnt = private_bdr_cnt = 0;
+  title[0] = '\0';
+  for (i=0; i<nfiles; i++) {
+    strncpy(name, files[i], sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    sx = sy = 0;
+    if (((at = strrchr(name, '@')) != NULL) &&
+        (sscanf(at+1, "%d,%d", &sx, &sy) == 2))
+      *at = '\0';
+    if (!read_sector_file(name, sx, sy))
+      return (FALSE);
+    if ((i == 0) || (sx < sx0)) sx0 = sx;
+    if ((i == 0) || (sy < sy0)) sy0 = sy;
+    if ((i == 0) || (sx > sx1)) sx1 = sx;
+    if ((i == 0) || (sy > sy1)) sy1 = sy;
+   }
+  if (nfiles == 0)
+    return (FALSE);
+  map_extent(sx0, sy0, sx1, sy1);
+  if (claim_radius >= 0)
+    border_claims(&map, claim_radius);
+  map_index();
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  map_print                                                       *
+ *                                                                           *
+ * Purpose:  Load 'nfiles' sector datafiles (see map_load()), then draw View *
+ *           'v' (the whole loaded area if v is NULL) with the raster device *
+ *           and write it to 'out_name'.  The raster is drawn by 'nthreads'  *
+ *           threads (one per processor if nthreads is 0).  A View wider or  *
+ *           taller than SHRT_MAX pixels is refused, as the devices take     *
+ *           16-bit XPoint and XSegment coordinates.                         *
+ *                                                                           *
+ *****************************************************************************/
+
+int map_print(nfiles, files, v, out_name, nthreads)
+int nfiles, nthreads;
+char **files, *out_name;
+View *v;
+{
+  int width, height, status;
+  Device *dev;
+  View all;
+
+  if (!map_load(nfiles, files))
+    return (FALSE);
+  if (v == NULL) {
+    all = map;
+    v = &all;
+   }
+  map_view_size(v, &width, &height);
+  if ((width > SHRT_MAX) || (height > SHRT_MAX)) {
+    fprintf(stderr,
+        "%s: A %d x %d map is too large (at most %d pixels a side)\n",
+        program_name, width, height, SHRT_MAX);
+    fprintf(stderr, "Use a smaller scale (-z) or view (-v)\n");
+    return (FALSE);
+   }
+  if ((out_format == FORMAT_SVG) || (out_format == FORMAT_PS)) {
+    if ((dev = vector_device(out_name, width, height,
+                out_format == FORMAT_PS)) == NULL)
+      return (FALSE);
+    gen_map(dev, v);
+    return (vector_close(dev));
+   }
+  if ((dev = raster_device(width, height)) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", program_name);
+    return (FALSE);
+   }
+  if (nthreads <= 0)
+    nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthreads > 1)
+    gen_map_threads(dev, v, nthreads);
+  else
+    gen_map(dev, v);
+  status = raster_write(dev, out_name, height);
+  raster_free(dev);
+  return (status);
+}
@@ -0,0 +1,846 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Client-side software rasterizer.  A raster Device
+ **                     draws the same primitives gen_sector() sends to X
+ **                     (wide and thin lines, tiled fills, filled and
+ **                     outlined arcs, base bitmaps and image text) into an
+ **                     in-memory framebuffer, so that 'ssv -p' can write
+ **                     its output file without ever opening a display.
+ **
+ **  File:              raster.c, containing the following subroutines:
+ **                       raster_device()
+ **                       raster_free()
+ **                       raster_band()
+ **                       raster_write_xwd()
+ **                       raster_write()
+ **                       raster_extension()
+ **                       raster_format()
+ **                       open_output()
+ **                       raster_font_size()
+ **                       raster_drop_scale()
+ **                       raster_from_image()
+ **                       raster_print_subsector()
+ **                       (and the static r_... drawing routines)
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <math.h>
+#include <unistd.h>
+
+/*****************************************************************************
+ **
+ **  These fonts are 95 character strips (' ' through '~') of fixed width
+ **  cells, standing in for the 8x13, 8x13bold and 6x10 server fonts.
+ **
+ *****************************************************************************/
+
+#include "bitmaps/font8x13.xbm"
+#include "bitmaps/font8x13b.xbm"
+#include "bitmaps/font6x10.xbm"
+
+typedef struct _rfont {
+        char *bits;
+        int width;                /* width of the whole strip */
+        int cell;                 /* width of one character */
+        int ascent, descent;
+        } RFont;
+
+static RFont r_fonts[NUM_FONTS] = {
+        { font8x13_bits,  font8x13_width,  font8x13_cell,  font8x13_ascent,
+                font8x13_height - font8x13_ascent },
+        { font8x13b_bits, font8x13b_width, font8x13b_cell, font8x13b_ascent,
+                font8x13b_height - font8x13b_ascent },
+        { font6x10_bits,  font6x10_width,  font6x10_cell,  font6x10_ascent,
+                font6x10_height - font6x10_ascent } };
+
+/*-- the fonts at each scale but 1, made the first time they are used --*/
+static RFont r_scaled[MAX_SCALES][NUM_FONTS];
+
+static RFont *r_font_at(font)
+int font;
+{
+  RFont *f = &r_fonts[font], *s = &r_scaled[geom->slot][font];
+  int height;
+
+  if (geom->scale == 1.0)
+    return (f);
+  if (s->bits == NULL) {
+    height = f->ascent + f->descent;
+    s->cell = (S(f->cell) > 0) ? S(f->cell) : 1;
+    s->width = s->cell * (f->width / f->cell);
+    s->ascent = S(f->ascent);
+    s->descent = ((S(height) > 0) ? S(height) : 1) - s->ascent;
+    s->bits = scale_bitmap(f->bits, f->width, height, f->cell, s->cell,
+                s->ascent + s->descent);
+   }
+  return (s);
+}
+
+/*****************************************************************************
+ **
+ **  The framebuffer holds one byte per pixel, PAPER or INK, with each
+ **  scanline padded to 32 bits so it can be written straight out as an
+ **  8 bit ZPixmap.  The pen and font fields mirror the black_gc state.
+ **
+ *****************************************************************************/
+
+typedef struct _raster {
+        int width, height, stride;
+        unsigned char *pix;
+        int top, bottom;          /* the scanlines it may draw on         */
+        int band;                 /* TRUE if pix belongs to another Raster */
+        int pen_width, pen_cap, pen_fill, font;
+        } Raster;
+
+#define RASTER(dev)     ((Raster *) (dev)->data)
+
+/*-- the output file format, set with '-f' --*/
+int out_format = FORMAT_XWD;
+
+/*-- if set, output goes down this descriptor instead of to the file named
+     (serve.c sets it to the client's socket) --*/
+int out_fd = -1;
+
+/*-- the color a FillTiled pixel takes: a set chex bit is white --*/
+#define TILE(x, y)      ((sm_chex_bits[((y) & 15) * 2 + (((x) & 15) >> 3)] \
+                                >> ((x) & 7)) & 1 ? PAPER : INK)
+
+static void r_span(r, y, x1, x2, color, fill)
+Raster *r;
+int y, x1, x2, color, fill;
+{
+  unsigned char *p;
+  int x;
+
+  if ((y < r->top) || (y >= r->bottom)) return;
+  if (x1 < 0) x1 = 0;
+  if (x2 >= r->width) x2 = r->width - 1;
+  if (x1 > x2) return;
+  p = r->pix + y * r->stride;
+  if ((color == INK) && (fill == FillTiled))
+    for (x=x1; x<=x2; x++)
+      p[x] = TILE(x, y);
+  else
+    memset(p + x1, color, x2 - x1 + 1);
+}
+
+#define r_plot(r, x, y)  r_span((r), (y), (x), (x), INK, (r)->pen_fill)
+
+/*-- zero width line: Bresenham, both end points drawn --*/
+static void r_thin_line(r, x1, y1, x2, y2)
+Raster *r;
+int x1, y1, x2, y2;
+{
+  int dx, dy, sx, sy, err, e2;
+
+  dx = abs(x2 - x1);  sx = (x1 < x2) ? 1 : -1;
+  dy = -abs(y2 - y1); sy = (y1 < y2) ? 1 : -1;
+  err = dx + dy;
+  for (;;) {
+    r_plot(r, x1, y1);
+    if ((x1 == x2) && (y1 == y2)) break;
+    e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x1 += sx; }
+    if (e2 <= dx) { err += dx; y1 += sy; }
+   }
+}
+
+/*-- fill a convex polygon: pixels whose centers fall inside are set --*/
+static void r_polygon(r, px, py, n, color, fill)
+Raster *r;
+double *px, *py;
+int n, color, fill;
+{
+  int i, j, y, ylo, yhi;
+  double yc, xl, xr, t, xi, miny, maxy;
+
+  miny = maxy = py[0];
+  for (i=1; i<n; i++) {
+    if (py[i] < miny) miny = py[i];
+    if (py[i] > maxy) maxy = py[i];
+   }
+  ylo = (int) ceil(miny - 0.5);
+  yhi = (int) ceil(maxy - 0.5) - 1;
+  for (y=ylo; y<=yhi; y++) {
+    yc = y + 0.5;
+    xl = 1e9;  xr = -1e9;
+    for (i=0, j=n-1; i<n; j=i++) {
+      if (((py[i] <= yc) && (py[j] > yc)) || ((py[j] <= yc) && (py[i] > yc))) {
+        t = (yc - py[j]) / (py[i] - py[j]);
+        xi = px[j] + t * (px[i] - px[j]);
+        if (xi < xl) xl = xi;
+        if (xi > xr) xr = xi;
+       }
+     }
+    if (xl <= xr)
+      r_span(r, y, (int) ceil(xl - 0.5), (int) ceil(xr - 0.5) - 1, color, fill);
+   }
+}
+
+/*-- fill the ellipse (or elliptical ring) inscribed in a box --*/
+static void r_ellipse(r, x, y, width, height, inner, outer, color, fill)
+Raster *r;
+int x, y, width, height, color, fill;
+double inner, outer;
+{
+  int px, py, run;
+  double cx, cy, dx, dy, d, aspect;
+
+  if ((width <= 0) || (height <= 0)) return;
+  cx = x + width / 2.0;
+  cy = y + height / 2.0;
+  aspect = (double) width / (double) height;
+  for (py=(int) floor(cy-outer*height/width); py<=(int) ceil(cy+outer*height/width); py++) {
+    dy = (py + 0.5 - cy) * aspect;
+    run = -1;
+    for (px=(int) floor(cx-outer); px<=(int) ceil(cx+outer)+1; px++) {
+      dx = px + 0.5 - cx;
+      d = sqrt(dx*dx + dy*dy);
+      if ((d <= outer) && (d >= inner)) {
+        if (run < 0) run = px;
+       }
+      else if (run >= 0) {
+        r_span(r, py, run, px-1, color, fill);
+        run = -1;
+       }
+     }
+   }
+}
+
+/*-- a line of the current pen width; round caps get a disc at each end --*/
+static void r_wide_line(r, x1, y1, x2, y2)
+Raster *r;
+int x1, y1, x2, y2;
+{
+  double px[4], py[4], len, nx, ny, hw;
+  int w;
+
+  w = r->pen_width;
+  if (w <= 1) {
+    r_thin_line(r, x1, y1, x2, y2);
+    return;
+   }
+  hw = w / 2.0;
+  len = sqrt((double) (x2-x1)*(x2-x1) + (double) (y2-y1)*(y2-y1));
+  if (len > 0) {
+    nx = -(y2 - y1) / len * hw;
+    ny =  (x2 - x1) / len * hw;
+    px[0] = x1 + nx;  py[0] = y1 + ny;
+    px[1] = x2 + nx;  py[1] = y2 + ny;
+    px[2] = x2 - nx;  py[2] = y2 - ny;
+    px[3] = x1 - nx;  py[3] = y1 - ny;
+    r_polygon(r, px, py, 4, INK, r->pen_fill);
+   }
+  if (r->pen_cap == CapRound) {
+    r_ellipse(r, x1-w/2, y1-w/2, w, w, 0.0, hw, INK, r->pen_fill);
+    r_ellipse(r, x2-w/2, y2-w/2, w, w, 0.0, hw, INK, r->pen_fill);
+   }
+}
+
+static void r_pen(dev, width, cap, fill)
+Device *dev;
+int width, cap, fill;
+{
+  RASTER(dev)->pen_width = width;
+  RASTER(dev)->pen_cap = cap;
+  RASTER(dev)->pen_fill = fill;
+}
+
+static void r_font(dev, font)
+Device *dev;
+int font;
+{
+  RASTER(dev)->font = font;
+}
+
+static int r_width(dev, font, str, len)
+Device *dev;
+int font, len;
+char *str;
+{
+  return (r_font_at(font)->cell * len);
+}
+
+static void r_line(dev, x1, y1, x2, y2)
+Device *dev;
+int x1, y1, x2, y2;
+{
+  r_wide_line(RASTER(dev), x1, y1, x2, y2);
+}
+
+static void r_lines(dev, pts, n, mode)
+Device *dev;
+XPoint *pts;
+int n, mode;
+{
+  int i, x, y, nx, ny;
+
+  x = pts[0].x;
+  y = pts[0].y;
+  for (i=1; i<n; i++) {
+    nx = (mode == CoordModePrevious) ? x + pts[i].x : pts[i].x;
+    ny = (mode == CoordModePrevious) ? y + pts[i].y : pts[i].y;
+    r_wide_line(RASTER(dev), x, y, nx, ny);
+    x = nx;
+    y = ny;
+   }
+}
+
+static void r_segments(dev, segs, n)
+Device *dev;
+XSegment *segs;
+int n;
+{
+  int i;
+
+  for (i=0; i<n; i++)
+    r_wide_line(RASTER(dev), segs[i].x1, segs[i].y1, segs[i].x2, segs[i].y2);
+}
+
+static void r_fill_rect(dev, color, x, y, width, height)
+Device *dev;
+int color, x, y, width, height;
+{
+  Raster *r = RASTER(dev);
+  int i;
+
+  for (i=y; i<y+height; i++)
+    r_span(r, i, x, x+width-1, color, (color == INK) ? r->pen_fill : FillSolid);
+}
+
+static void r_draw_rect(dev, x, y, width, height)
+Device *dev;
+int x, y, width, height;
+{
+  Raster *r = RASTER(dev);
+  int i, lo, hi;
+
+  if (r->pen_width <= 1) {
+    r_thin_line(r, x, y, x+width, y);
+    r_thin_line(r, x+width, y, x+width, y+height);
+    r_thin_line(r, x+width, y+height, x, y+height);
+    r_thin_line(r, x, y+height, x, y);
+    return;
+   }
+/*-- mitered outline: the band between the outer and inner rectangles --*/
+  lo = (int) ceil(-r->pen_width / 2.0 - 0.5);
+  hi = (int) ceil(r->pen_width / 2.0 - 0.5) - 1;
+  for (i=y+lo; i<=y+height+hi; i++) {
+    if ((i <= y+hi) || (i >= y+height+lo))
+      r_span(r, i, x+lo, x+width+hi, INK, r->pen_fill);
+    else {
+      r_span(r, i, x+lo, x+hi, INK, r->pen_fill);
+      r_span(r, i, x+width+lo, x+width+hi, INK, r->pen_fill);
+     }
+   }
+}
+
+static void r_fill_arc(dev, color, x, y, width, height)
+Device *dev;
+int color, x, y, width, height;
+{
+  Raster *r = RASTER(dev);
+
+  r_ellipse(r, x, y, width, height, 0.0, width / 2.0, color,
+                (color == INK) ? r->pen_fill : FillSolid);
+}
+
+static void r_draw_arc(dev, x, y, width, height)
+Device *dev;
+int x, y, width, height;
+{
+  Raster *r = RASTER(dev);
+  double hw;
+
+  hw = (r->pen_width <= 1) ? 0.5 : r->pen_width / 2.0;
+  r_ellipse(r, x, y, width, height, width / 2.0 - hw, width / 2.0 + hw,
+                INK, r->pen_fill);
+}
+
+/*-- an opaque copy, like XCopyArea from the black-on-white base pixmaps --*/
+static void r_symbol(dev, sym, x, y)
+Device *dev;
+int sym, x, y;
+{
+  Raster *r = RASTER(dev);
+  Symbol *s = scaled_symbol(sym);
+  int i, j, bpl, set;
+
+  bpl = (s->width + 7) / 8;
+  for (j=0; j<s->height; j++) {
+    if ((y+j < r->top) || (y+j >= r->bottom)) continue;
+    for (i=0; i<s->width; i++) {
+      if ((x+i < 0) || (x+i >= r->width)) continue;
+      set = (s->bits[j*bpl + (i>>3)] >> (i & 7)) & 1;
+      r->pix[(y+j) * r->stride + x+i] = set ? INK : PAPER;
+     }
+   }
+}
+
+/*-- XDrawImageString: paint the cell background, then the glyphs --*/
+static void r_text(dev, x, y, str, len)
+Device *dev;
+int x, y, len;
+char *str;
+{
+  Raster *r = RASTER(dev);
+  RFont *f = r_font_at(r->font);
+  int c, i, j, k, gx, bpl;
+
+  bpl = (f->width + 7) / 8;
+  r_fill_rect(dev, PAPER, x, y - f->ascent, f->cell * len,
+                f->ascent + f->descent);
+  for (k=0; k<len; k++) {
+    c = (unsigned char) str[k];
+    if ((c < ' ') || (c > '~')) continue;
+    gx = (c - ' ') * f->cell;
+    for (j=0; j<f->ascent + f->descent; j++)
+      for (i=0; i<f->cell; i++)
+        if ((f->bits[j*bpl + ((gx+i)>>3)] >> ((gx+i) & 7)) & 1)
+          r_span(r, y - f->ascent + j, x + k*f->cell + i,
+                x + k*f->cell + i, INK, FillSolid);
+   }
+}
+
+static void r_flush(dev)
+Device *dev;
+{
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  raster_device                                                   *
+ *                                                                           *
+ * Purpose:  Allocate a width x height framebuffer, cleared to PAPER, and a  *
+ *           Device that draws into it.  Returns NULL if out of memory.      *
+ *                                                                           *
+ *****************************************************************************/
+
+Device *raster_device(width, height)
+int width, height;
+{
+  Device *dev;
+  Raster *r;
+
+  dev = (Device *) malloc(sizeof(Device));
+  r = (Raster *) malloc(sizeof(Raster));
+  if ((dev == NULL) || (r == NULL))
+    return (NULL);
+  r->width = width;
+  r->height = height;
+  r->stride = (width + 3) & ~3;
+  r->pix = (unsigned char *) malloc(r->stride * height);
+  if (r->pix == NULL)
+    return (NULL);
+  memset(r->pix, PAPER, r->stride * height);
+  r->top = 0;
+  r->bottom = height;
+  r->band = FALSE;
+  r->pen_width = 1;
+  r->pen_cap = CapButt;
+  r->pen_fill = FillSolid;
+  r->font = FONT_NORMAL;
+
+  dev->pen = r_pen;
+  dev->font = r_font;
+  dev->width = r_width;
+  dev->line = r_line;
+  dev->lines = r_lines;
+  dev->segments = r_segments;
+  dev->fill_rect = r_fill_rect;
+  dev->draw_rect = r_draw_rect;
+  dev->fill_arc = r_fill_arc;
+  dev->draw_arc = r_draw_arc;
+  dev->symbol = r_symbol;
+  dev->text = r_text;
+  dev->flush = r_flush;
+  dev->data = (char *) r;
+  return (dev);
+}
+
+void raster_free(dev)
+Device *dev;
+{
+  if (!RASTER(dev)->band)
+    free(RASTER(dev)->pix);
+  free(dev->data);
+  free(dev);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  raster_band                                                     *
+ *                                                                           *
+ * Purpose:  A second Device on the framebuffer of 'dev' that only draws on  *
+ *           scanlines 'top' to 'bottom'-1, with its own pen and font.       *
+ *           Devices on bands that do not overlap can draw at the same time  *
+ *           from different threads.  raster_free() leaves the framebuffer   *
+ *           to 'dev'.  Returns NULL if out of memory.                       *
+ *                                                                           *
+ *****************************************************************************/
+
+Device *raster_band(dev, top, bottom)
+Device *dev;
+int top, bottom;
+{
+  Device *band;
+  Raster *r;
+
+  band = (Device *) malloc(sizeof(Device));
+  r = (Raster *) malloc(sizeof(Raster));
+  if ((band == NULL) || (r == NULL))
+    return (NULL);
+  *band = *dev;
+  *r = *RASTER(dev);
+  r->top = (top > 0) ? top : 0;
+  r->bottom = (bottom < r->height) ? bottom : r->height;
+  r->band = TRUE;
+  r->pen_width = 1;
+  r->pen_cap = CapButt;
+  r->pen_fill = FillSolid;
+  r->font = FONT_NORMAL;
+  band->data = (char *) r;
+  return (band);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  raster_write_xwd                                                *
+ *                                                                           *
+ * Purpose:  Write the top 'height' scanlines of a raster Device to 'name'   *
+ *           as an 8 bit ZPixmap xwd file with a 2 entry colormap (pixel 0   *
+ *           is PAPER/white, pixel 1 is INK/black), readable by xwud and     *
+ *           xpr just like the files print_subsector() writes.               *
+ *                                                                           *
+ *****************************************************************************/
+
+int raster_write_xwd(dev, name, height)
+Device *dev;
+char *name;
+int height;
+{
+  unsigned long swaptest = TRUE;
+  Raster *r = RASTER(dev);
+  IMGFileHeader header;
+  IMGColor colors[2];
+  int win_name_size, i, status;
+  double start;
+  FILE *out;
+
+  if (height > r->height)
+    height = r->height;
+  if ((out = open_output(name)) == NULL)
+    return (FALSE);
+
+  win_name_size = strlen(name) + sizeof(char);
+
+  memset((char *) &header, 0, sizeof(header));
+  header.header_size = (imgval) (sizeof(header) + win_name_size);
+  header.file_version = (imgval) XWD_FILE_VERSION;
+  header.pixmap_format = (imgval) ZPixmap;
+  header.pixmap_depth = (imgval) 8;
+  header.pixmap_width = (imgval) r->width;
+  header.pixmap_height = (imgval) height;
+  header.xoffset = (imgval) 0;
+  header.byte_order = (imgval) MSBFirst;
+  header.bitmap_unit = (imgval) 32;
+  header.bitmap_bit_order = (imgval) MSBFirst;
+  header.bitmap_pad = (imgval) 32;
+  header.bits_per_pixel = (imgval) 8;
+  header.bytes_per_line = (imgval) r->stride;
+  header.visual_class = (imgval) PseudoColor;
+  header.bits_per_rgb = (imgval) 8;
+  header.colormap_entries = (imgval) 256;
+  header.ncolors = (imgval) 2;
+  header.window_width = (imgval) r->width;
+  header.window_height = (imgval) height;
+
+  memset((char *) colors, 0, sizeof(colors));
+  colors[PAPER].pixel = PAPER;
+  colors[PAPER].red = colors[PAPER].green = colors[PAPER].blue = 0xffff;
+  colors[INK].pixel = INK;
+  for (i=0; i<2; i++)
+    colors[i].flags = DoRed | DoGreen | DoBlue;
+
+  if (*(char *) &swaptest) {
+    _swaplong((char *) &header, sizeof(header));
+    for (i = 0; i < 2; i++) {
+        _swaplong((char *) &colors[i].pixel, sizeof(imgval));
+        _swapshort((char *) &colors[i].red, 3 * sizeof(short));
+    }
+  }
+
+  start = stats_clock();
+  (void) fwrite((char *) &header, sizeof(header), 1, out);
+  (void) fwrite(name, win_name_size, 1, out);
+  (void) fwrite((char *) colors, sizeof(IMGColor), 2, out);
+  (void) fwrite((char *) r->pix, r->stride, height, out);
+
+  status = (fclose(out) == 0);
+  stats_bytes += sizeof(header) + win_name_size + 2 * sizeof(IMGColor) +
+                r->stride * height;
+  stats_time(STAT_WRITE, start);
+  return (status);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  write_bitmap                                                    *
+ *                                                                           *
+ * Purpose:  Write the top 'height' scanlines of a raster Device packed 8    *
+ *           pixels to the byte, INK as a set bit, most significant bit      *
+ *           first: as a binary PBM (P4) file if 'pbm' is set, otherwise as  *
+ *           a depth 1 XYBitmap xwd file, each scanline padded to 32 bits,   *
+ *           with the same 2 entry colormap as raster_write_xwd().           *
+ *                                                                           *
+ *****************************************************************************/
+
+static int write_bitmap(dev, name, height, pbm)
+Device *dev;
+char *name;
+int height, pbm;
+{
+  unsigned long swaptest = TRUE;
+  Raster *r = RASTER(dev);
+  IMGFileHeader header;
+  IMGColor colors[2];
+  unsigned char *bits, *b, *p;
+  int win_name_size, bpl, i, x, y, status;
+  double start;
+  FILE *out;
+
+  if (height > r->height)
+    height = r->height;
+  bpl = pbm ? (r->width + 7) / 8 : ((r->width + 31) / 32) * 4;
+  if ((bits = (unsigned char *) calloc(bpl, height)) == NULL)
+    return (FALSE);
+  for (y=0; y<height; y++) {
+    p = r->pix + y * r->stride;
+    b = bits + y * bpl;
+    for (x=0; x<r->width; x++)
+      if (p[x] == INK)
+        b[x >> 3] |= 0x80 >> (x & 7);
+   }
+  if ((out = open_output(name)) == NULL) {
+    free((char *) bits);
+    return (FALSE); }
+
+  start = stats_clock();
+  if (pbm) {
+    i = fprintf(out, "P4\n%d %d\n", r->width, height);
+    stats_bytes += i;
+   }
+  else {
+    win_name_size = strlen(name) + sizeof(char);
+
+    memset((char *) &header, 0, sizeof(header));
+    header.header_size = (imgval) (sizeof(header) + win_name_size);
+    header.file_version = (imgval) XWD_FILE_VERSION;
+    header.pixmap_format = (imgval) XYBitmap;
+    header.pixmap_depth = (imgval) 1;
+    header.pixmap_width = (imgval) r->width;
+    header.pixmap_height = (imgval) height;
+    header.xoffset = (imgval) 0;
+    header.byte_order = (imgval) MSBFirst;
+    header.bitmap_unit = (imgval) 32;
+    header.bitmap_bit_order = (imgval) MSBFirst;
+    header.bitmap_pad = (imgval) 32;
+    header.bits_per_pixel = (imgval) 1;
+    header.bytes_per_line = (imgval) bpl;
+    header.visual_class = (imgval) StaticGray;
+    header.bits_per_rgb = (imgval) 1;
+    header.colormap_entries = (imgval) 2;
+    header.ncolors = (imgval) 2;
+    header.window_width = (imgval) r->width;
+    header.window_height = (imgval) height;
+
+    memset((char *) colors, 0, sizeof(colors));
+    colors[PAPER].pixel = PAPER;
+    colors[PAPER].red = colors[PAPER].green = colors[PAPER].blue = 0xffff;
+    colors[INK].pixel = INK;
+    for (i=0; i<2; i++)
+      colors[i].flags = DoRed | DoGreen | DoBlue;
+
+    if (*(char *) &swaptest) {
+      _swaplong((char *) &header, sizeof(header));
+      for (i = 0; i < 2; i++) {
+          _swaplong((char *) &colors[i].pixel, sizeof(imgval));
+          _swapshort((char *) &colors[i].red, 3 * sizeof(short));
+      }
+    }
+
+    (void) fwrite((char *) &header, sizeof(header), 1, out);
+    (void) fwrite(name, win_name_size, 1, out);
+    (void) fwrite((char *) colors, sizeof(IMGColor), 2, out);
+    stats_bytes += sizeof(header) + win_name_size + 2 * sizeof(IMGColor);
+   }
+  (void) fwrite((char *) bits, bpl, height, out);
+  free((char *) bits);
+
+  status = (fclose(out) == 0);
+  stats_bytes += bpl * height;
+  stats_time(STAT_WRITE, start);
+  return (status);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: raster_write, raster_extension                                  *
+ *                                                                           *
+ * Purpose:  Write the top 'height' scanlines of a raster Device to 'name'   *
+ *           in the format chosen with '-f' (out_format): an 8 bit xwd file, *
+ *           a 1 bit XYBitmap xwd file or a PBM file.  raster_extension()    *
+ *           gives the usual file name ending for the format.                *
+ *                                                                           *
+ *****************************************************************************/
+
+int raster_write(dev, name, height)
+Device *dev;
+char *name;
+int height;
+{
+  switch (out_format) {
+    case FORMAT_BITMAP : return (write_bitmap(dev, name, height, FALSE));
+    case FORMAT_PBM    : return (write_bitmap(dev, name, height, TRUE));
+   }
+  return (raster_write_xwd(dev, name, height));
+}
+
+char *raster_extension()
+{
+  switch (out_format) {
+    case FORMAT_PBM : return (".pbm");
+    case FORMAT_SVG : return (".svg");
+    case FORMAT_PS  : return (".ps");
+   }
+  return (".xwd");
+}
+
+/*-- the format called 'name' ("xwd", "bitmap", "pbm", "svg" or "ps"),
+     or -1 --*/
+int raster_format(name)
+char *name;
+{
+  static char *format_name[] = { "xwd", "bitmap", "pbm", "svg", "ps" };
+  int i;
+
+  for (i=0; i<sizeof(format_name)/sizeof(format_name[0]); i++)
+    if (strcmp(name, format_name[i]) == 0)
+      return (i);
+  return (-1);
+}
+
+/*-- open the output file 'name' for writing, or a stream on out_fd --*/
+FILE *open_output(name)
+char *name;
+{
+  int fd;
+  FILE *out;
+
+  if (out_fd < 0)
+    return (fopen(name, "w"));
+  if ((fd = dup(out_fd)) < 0)
+    return (NULL);
+  if ((out = fdopen(fd, "w")) == NULL)
+    close(fd);
+  return (out);
+}
+
+/*-- the cell width, ascent and descent of one of the built-in fonts,
+     at the current scale --*/
+void raster_font_size(font, cell, ascent, descent)
+int font, *cell, *ascent, *descent;
+{
+  RFont *f = r_font_at(font);
+
+  *cell = f->cell;
+  *ascent = f->ascent;
+  *descent = f->descent;
+}
+
+/*-- free the fonts made for the scale kept in 'slot': set_scale() is
+     giving the slot to another scale --*/
+void raster_drop_scale(slot)
+int slot;
+{
+  int i;
+
+  for (i=0; i<NUM_FONTS; i++) {
+    if (r_scaled[slot][i].bits != NULL)
+      free(r_scaled[slot][i].bits);
+    r_scaled[slot][i].bits = NULL;
+   }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  raster_from_image                                               *
+ *                                                                           *
+ * Purpose:  A raster Device holding a copy of XImage 'img', every pixel of  *
+ *           the color 'paper' as PAPER and every other as INK, so a map     *
+ *           read back from the server can be written by raster_write().     *
+ *           Returns NULL if out of memory.                                  *
+ *                                                                           *
+ *****************************************************************************/
+
+Device *raster_from_image(img, paper)
+XImage *img;
+unsigned long paper;
+{
+  Device *dev;
+  Raster *r;
+  int x, y;
+
+  if ((dev = raster_device(img->width, img->height)) == NULL)
+    return (NULL);
+  r = RASTER(dev);
+  for (y=0; y<img->height; y++)
+    for (x=0; x<img->width; x++)
+      r->pix[y * r->stride + x] = (XGetPixel(img, x, y) == paper) ? PAPER : INK;
+  return (dev);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  raster_print_subsector                                          *
+ *                                                                           *
+ * Purpose:  The display-free counterpart of print_subsector(): draw the     *
+ *           loaded subsector into a framebuffer and write it to 'name', or  *
+ *           for '-f svg' and '-f ps' draw it straight to a vector Device.   *
+ *                                                                           *
+ *****************************************************************************/
+
+int raster_print_subsector(name)
+char *name;
+{
+  Device *dev;
+  int status;
+
+  if ((out_format == FORMAT_SVG) || (out_format == FORMAT_PS)) {
+    if ((dev = vector_device(name, MAP_WIDTH, PRINT_HEIGHT,
+                out_format == FORMAT_PS)) == NULL)
+      return (FALSE);
+    gen_sector(dev);
+    return (vector_close(dev));
+   }
+  if ((dev = raster_device(MAP_WIDTH, MAP_HEIGHT)) == NULL)
+    return (FALSE);
+  gen_sector(dev);
+  status = raster_write(dev, name, PRINT_HEIGHT);
+  raster_free(dev);
+  return (status);
+}
@@ -0,0 +1,419 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Jump routes.  With '-t jump' the worlds of one or
+ **                     more sectors are joined into a graph, each world to
+ **                     every world within 'jump' hexes of it, and routes
+ **                     are found on it by A* search on the hex distance:
+ **                     either the shortest route between two hexes ('-P'),
+ **                     or the trade route network implied by the starports.
+ **                     The routes are printed on stdout as '$' lines, ready
+ **                     to be put into the datafiles.
+ **
+ **  File:              route.c, containing the following subroutines:
+ **                       hex_distance()
+ **                       route_between()
+ **                       route_print()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+#define MAX_JUMP  6             /* so a jump never spans a whole subsector */
+#define MAX_REACH 4             /* the longest trade route, in hexes       */
+
+/*-- the '-P' requests: absolute hexes, from and to --*/
+static int *ask, ask_cnt, ask_max;
+
+/*-- the jump graph: the worlds within 'jump' of world i are
+     nbr_list[nbr_first[i]..nbr_first[i+1]-1] --*/
+static int *nbr_first, *nbr_list, first_max, list_max;
+
+/*-- a jump found: from and to worlds, and the sector it is listed in --*/
+typedef struct _jump {
+        int from, to, sx, sy;
+        } Jump;
+
+static Jump *jumps;
+static int jump_cnt, jumps_max;
+
+/*****************************************************************************
+ **
+ **  The trade routes: two worlds are joined if they are no further apart
+ **  than reach[port][port] hexes.  The better the starports, the further
+ **  trade will go; ports D and E only trade with their neighbours' A and
+ **  B ports, and X not at all.
+ **
+ *****************************************************************************/
+
+static int reach[5][5] = {
+/*          A  B  C  D  E */
+/* A */   { 4, 3, 2, 1, 1 },
+/* B */   { 3, 3, 2, 1, 1 },
+/* C */   { 2, 2, 1, 0, 0 },
+/* D */   { 1, 1, 0, 0, 0 },
+/* E */   { 1, 1, 0, 0, 0 } };
+
+static int port(w)
+World *w;
+{
+  return (((w->Starport[0] >= 'A') && (w->Starport[0] <= 'E')) ?
+          w->Starport[0] - 'A' : -1);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  hex_distance                                                    *
+ *                                                                           *
+ * Purpose:  The number of hexes between absolute hexes [c1, r1] and         *
+ *           [c2, r2].  Odd columns are half a hex lower, so each column     *
+ *           crossed takes in half a row for free.                           *
+ *                                                                           *
+ *****************************************************************************/
+
+int hex_distance(c1, r1, c2, r2)
+int c1, r1, c2, r2;
+{
+  int dx, dy, dz;
+
+/*--- as cube coordinates: x + y + z = 0 ---*/
+  dx = c2 - c1;
+  dz = (r2 - (c2 - (c2 & 1)) / 2) - (r1 - (c1 - (c1 & 1)) / 2);
+  dy = -dx - dz;
+  if (dx < 0) dx = -dx;
+  if (dy < 0) dy = -dy;
+  if (dz < 0) dz = -dz;
+  return ((dx > dy) ? ((dx > dz) ? dx : dz) : ((dy > dz) ? dy : dz));
+}
+
+/*-- call fn(i, k, arg) for each world k within 'dist' of world i, found by
+     hex through world_at(), so the cost does not depend on w_cnt --*/
+static void near_worlds(i, dist, fn, arg)
+int i, dist;
+void (*fn)();
+char *arg;
+{
+  World *w = &sec_world[i];
+  int c, r, k;
+
+  for (c=w->col-dist; c<=w->col+dist; c++)
+    for (r=w->row-dist-1; r<=w->row+dist+1; r++) {
+      if (((c == w->col) && (r == w->row)) ||
+          (hex_distance(w->col, w->row, c, r) > dist) ||
+          ((k = world_at(c, r)) < 0))
+        continue;
+      (*fn)(i, k, arg);
+     }
+}
+
+static int nbr_fill;
+
+static void count_nbr(i, k, arg)
+int i, k;
+char *arg;
+{
+  nbr_first[i+1]++;
+}
+
+static void list_nbr(i, k, arg)
+int i, k;
+char *arg;
+{
+  nbr_list[nbr_fill++] = k;
+}
+
+static int *cost, *prev, *seen, *done, search_gen, node_max[4];
+static int *heap, *heap_f, heap_cnt, heap_max[2];
+
+/*-- the jump graph, counted then listed, as in map_index() --*/
+static void jump_graph(jump)
+int jump;
+{
+  int i;
+
+  nbr_first = (int *) grow((char *) nbr_first, &first_max, w_cnt + 1,
+                sizeof(int));
+  for (i=0; i<=w_cnt; i++)
+    nbr_first[i] = 0;
+  for (i=0; i<w_cnt; i++)
+    if (world_at(sec_world[i].col, sec_world[i].row) == i)
+      near_worlds(i, jump, count_nbr, NULL);
+  for (i=0; i<w_cnt; i++)
+    nbr_first[i+1] += nbr_first[i];
+  nbr_list = (int *) grow((char *) nbr_list, &list_max, nbr_first[w_cnt],
+                sizeof(int));
+  nbr_fill = 0;
+  for (i=0; i<w_cnt; i++)
+    if (world_at(sec_world[i].col, sec_world[i].row) == i)
+      near_worlds(i, jump, list_nbr, NULL);
+
+  cost = (int *) grow((char *) cost, &node_max[0], w_cnt, sizeof(int));
+  prev = (int *) grow((char *) prev, &node_max[1], w_cnt, sizeof(int));
+  seen = (int *) grow((char *) seen, &node_max[2], w_cnt, sizeof(int));
+  done = (int *) grow((char *) done, &node_max[3], w_cnt, sizeof(int));
+  for (i=0; i<w_cnt; i++)
+    seen[i] = done[i] = 0;
+  search_gen = 0;
+}
+
+/*****************************************************************************
+ **
+ **  A* search over the jump graph.  Every jump costs 1, and a world 'd'
+ **  hexes from the goal is at least (d + jump - 1) / jump jumps from it,
+ **  so the estimate never overshoots and the first route to reach the
+ **  goal is a shortest one.  The per-world arrays are stamped with the
+ **  search that last touched them instead of being cleared for each.
+ **
+ *****************************************************************************/
+
+static void heap_push(k, f)
+int k, f;
+{
+  int i, p;
+
+  heap = (int *) grow((char *) heap, &heap_max[0], heap_cnt, sizeof(int));
+  heap_f = (int *) grow((char *) heap_f, &heap_max[1], heap_cnt, sizeof(int));
+  for (i=heap_cnt++; i > 0; i=p) {
+    p = (i - 1) / 2;
+    if (heap_f[p] <= f)
+      break;
+    heap[i] = heap[p];
+    heap_f[i] = heap_f[p];
+   }
+  heap[i] = k;
+  heap_f[i] = f;
+}
+
+static int heap_pop()
+{
+  int i, c, k, f, top;
+
+  top = heap[0];
+  k = heap[--heap_cnt];
+  f = heap_f[heap_cnt];
+  for (i=0; (c = 2 * i + 1) < heap_cnt; i=c) {
+    if ((c + 1 < heap_cnt) && (heap_f[c+1] < heap_f[c]))
+      c++;
+    if (f <= heap_f[c])
+      break;
+    heap[i] = heap[c];
+    heap_f[i] = heap_f[c];
+   }
+  heap[i] = k;
+  heap_f[i] = f;
+  return (top);
+}
+
+/*-- the jumps from world 'from' to world 'to', put in 'jumps'; returns
+     FALSE if there is no route of at most 'limit' jumps (or, if 'limit' is
+     negative, none at all).  The search stops once the best estimate left
+     on the heap is past the limit, so an unreachable goal does not search
+     the whole of the graph it is joined to --*/
+static int find_route(from, to, jump, limit)
+int from, to, jump, limit;
+{
+  World *g = &sec_world[to];
+  int i, k, n, d;
+
+  search_gen++;
+  heap_cnt = 0;
+  cost[from] = 0;
+  prev[from] = -1;
+  seen[from] = search_gen;
+  heap_push(from, 0);
+  while ((heap_cnt > 0) && ((limit < 0) || (heap_f[0] <= limit))) {
+    n = heap_pop();
+    if (done[n] == search_gen)
+      continue;
+    done[n] = search_gen;
+    if (n == to)
+      break;
+    for (i=nbr_first[n]; i<nbr_first[n+1]; i++) {
+      k = nbr_list[i];
+      if ((done[k] == search_gen) ||
+          ((seen[k] == search_gen) && (cost[k] <= cost[n] + 1)))
+        continue;
+      seen[k] = search_gen;
+      cost[k] = cost[n] + 1;
+      prev[k] = n;
+      d = hex_distance(sec_world[k].col, sec_world[k].row, g->col, g->row);
+      heap_push(k, cost[k] + (d + jump - 1) / jump);
+     }
+   }
+  if (done[to] != search_gen)
+    return (FALSE);
+  for (k=to; prev[k] >= 0; k=prev[k]) {
+    jumps = (Jump *) grow((char *) jumps, &jumps_max, jump_cnt, sizeof(Jump));
+    jumps[jump_cnt].from = prev[k];
+    jumps[jump_cnt++].to = k;
+   }
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  route_between                                                   *
+ *                                                                           *
+ * Purpose:  Ask for the shortest route from absolute hex [c1, r1] to        *
+ *           [c2, r2] (from 0, counting on into the sectors to the right     *
+ *           and below) to be printed by route_print().                      *
+ *                                                                           *
+ *****************************************************************************/
+
+void route_between(c1, r1, c2, r2)
+int c1, r1, c2, r2;
+{
+  ask = (int *) grow((char *) ask, &ask_max, 4 * ask_cnt + 3, sizeof(int));
+  ask[4*ask_cnt] = c1;
+  ask[4*ask_cnt+1] = r1;
+  ask[4*ask_cnt+2] = c2;
+  ask[4*ask_cnt+3] = r2;
+  ask_cnt++;
+}
+
+/*-- the trade route between worlds i and k, if their ports reach; as every
+     jump covers at least a hex, a route of more jumps than the reach in
+     hexes is a detour no trade would take, and is not looked for --*/
+static void trade_route(i, k, arg)
+int i, k;
+char *arg;
+{
+  World *a = &sec_world[i], *b = &sec_world[k];
+  int jump = *(int *) arg, r;
+
+  if ((k < i) || (port(b) < 0) ||
+      (hex_distance(a->col, a->row, b->col, b->row) >
+                (r = reach[port(a)][port(b)])))
+    return;
+  find_route(i, k, jump, r);
+}
+
+/*-- the sector (or subsector, with n the hexes across one) of hex c --*/
+static int sector_of(c, n)
+int c, n;
+{
+  return ((c >= 0) ? c / n : -((-c + n - 1) / n));
+}
+
+/*-- the order jumps are listed in: by the sector of the world they are
+     listed from, then by its hex, then by the other's --*/
+static int by_world(a, b)
+World *a, *b;
+{
+  int d;
+
+  if ((d = sector_of(a->row, SECTOR_ROWS) - sector_of(b->row, SECTOR_ROWS)))
+    return (d);
+  if ((d = sector_of(a->col, SECTOR_COLS) - sector_of(b->col, SECTOR_COLS)))
+    return (d);
+  if ((d = a->col - b->col) != 0)
+    return (d);
+  return (a->row - b->row);
+}
+
+static int by_sector(a, b)
+Jump *a, *b;
+{
+  int d;
+
+  if ((d = by_world(&sec_world[a->from], &sec_world[b->from])) != 0)
+    return (d);
+  return (by_world(&sec_world[a->to], &sec_world[b->to]));
+}
+
+static int sign(n)
+int n;
+{
+  return ((n > 0) - (n < 0));
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  route_print                                                     *
+ *                                                                           *
+ * Purpose:  Load 'nfiles' sector datafiles (see map_load()) and print on    *
+ *           stdout, as '$' lines, the routes asked for with route_between() *
+ *           or, if none were, the trade route network: each pair of worlds  *
+ *           whose starports reach each other, joined by a shortest route of *
+ *           jumps of at most 'jump' hexes.  Each jump is printed once, from *
+ *           the world that comes first (by sector, then hex), under a '#'   *
+ *           line naming the sector its hex numbers belong to; the offsets   *
+ *           say which way the other world is when it lies in another        *
+ *           subsector.  Returns FALSE if a file cannot be read, or a route  *
+ *           asked for cannot be made.                                       *
+ *                                                                           *
+ *****************************************************************************/
+
+int route_print(nfiles, files, jump)
+int nfiles, jump;
+char **files;
+{
+  World *a, *b;
+  Jump *j;
+  int i, k, t, status = TRUE;
+
+  if ((jump < 1) || (jump > MAX_JUMP)) {
+    fprintf(stderr, "%s: Jump must be 1 to %d\n", program_name, MAX_JUMP);
+    return (FALSE);
+   }
+  if (!map_load(nfiles, files))
+    return (FALSE);
+  jump_graph(jump);
+  jump_cnt = 0;
+
+  for (t=0; t<ask_cnt; t++) {
+    i = world_at(ask[4*t], ask[4*t+1]);
+    k = world_at(ask[4*t+2], ask[4*t+3]);
+    if ((i < 0) || (k < 0) || !find_route(i, k, jump, -1)) {
+      fprintf(stderr, "%s: No jump-%d route from %d,%d to %d,%d\n",
+                program_name, jump, ask[4*t] + 1, ask[4*t+1] + 1,
+                ask[4*t+2] + 1, ask[4*t+3] + 1);
+      status = FALSE;
+     }
+   }
+  if (ask_cnt == 0)
+    for (i=0; i<w_cnt; i++)
+      if ((port(&sec_world[i]) >= 0) &&
+          (world_at(sec_world[i].col, sec_world[i].row) == i))
+        near_worlds(i, MAX_REACH, trade_route, (char *) &jump);
+
+/*--- list each jump from its first world, sort and drop repeats ---*/
+  for (i=0; i<jump_cnt; i++) {
+    j = &jumps[i];
+    if (by_world(&sec_world[j->to], &sec_world[j->from]) < 0) {
+      t = j->from;
+      j->from = j->to;
+      j->to = t;
+     }
+    j->sx = sector_of(sec_world[j->from].col, SECTOR_COLS);
+    j->sy = sector_of(sec_world[j->from].row, SECTOR_ROWS);
+   }
+  if (jump_cnt > 0)
+    qsort((char *) jumps, jump_cnt, sizeof(Jump), by_sector);
+
+  for (i=0; i<jump_cnt; i++) {
+    j = &jumps[i];
+    if ((i > 0) && (by_sector(j, j - 1) == 0))
+      continue;
+    if ((i == 0) || (j->sx != j[-1].sx) || (j->sy != j[-1].sy))
+      printf("# sector %d,%d\n", j->sx, j->sy);
+    a = &sec_world[j->from];
+    b = &sec_world[j->to];
+    printf("$%.4s %.4s %2d%2d\n", a->hex, b->hex,
+           sign(sector_of(b->col, NUM_HEXES) - sector_of(a->col, NUM_HEXES)),
+           sign(sector_of(b->row, NUM_LINES) - sector_of(a->row, NUM_LINES)));
+   }
+  return (status);
+}
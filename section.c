@@ -11,16 +11,33 @@
  **                     sub-sector maps based on the UWP datafiles).
  **
  **                     To use, invoke as follows:
- **                          section [sector_datafile]
+ **                          section sector_datafile ...
  **
- **                     Section will automatically produce 16 output files
- **                     named sec_A through sec_P.  Each file will contain,
- **                     on the first line of it's header, the name of the
- **                     sector (using the name of the file given to section
- **                     as a parameter) and a dummy subsector name (using
- **                     the name of the output file: sec_A - sec_P).  The
- **                     user must manually edit in correct subsector names
- **                     after the 16 subsector files are created.
+ **                     Given one datafile, section produces 16 output
+ **                     files named sec_A through sec_P.  Given several,
+ **                     each is a sector of its own and its 16 files are
+ **                     named after it: spinward.dat gives spinward_A
+ **                     through spinward_P.  A comment line '#SECTOR: name'
+ **                     in a datafile starts another sector, called 'name'
+ **                     ('@' title lines are dropped as always), so one file
+ **                     (or '-', the standard input) may hold any number of
+ **                     sectors, each one's lines together.  Each file
+ **                     will contain, on the first line of it's header,
+ **                     the name of the sector and a dummy subsector name
+ **                     (the name of the output file).  The user must
+ **                     manually edit in correct subsector names after the
+ **                     subsector files are created.
+ **
+ **                     The input is read in large blocks and each output
+ **                     file is written from a buffer of its own, so lines
+ **                     may be of any length and the time taken is mostly
+ **                     that of the disk.  Lines whose hex is not in
+ **                     0101..3240 are skipped and counted.
+ **
+ **                     A tab delimited (T5 SEC) datafile is split by its
+ **                     Hex column, found from its header line, which is
+ **                     copied into each output file; a change in its
+ **                     Sector column starts another sector, named by it.
  **
  **                     This program is designed to be a pre-formatter for
  **                     the ssv (sub-sector viewer) program and expects
@@ -29,6 +46,12 @@
  **
  **  File:		Section.c, containing the following routines:
  **                       main()
+ **                       out_flush()
+ **                       out_put()
+ **                       sector_open()
+ **                       sector_close()
+ **                       split_line()
+ **                       split_file()
  **
  **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
  **				Interface Technology Operation
@@ -45,7 +68,12 @@
  *****************************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 char *header[8] = {
     "#",
@@ -61,87 +89,455 @@ char *header[8] = {
 #define  FALSE  0
 
 #define  NUM_SSECS  16
+#define  NUM_COLS   32        /* hexes across a sector */
+#define  NUM_ROWS   40        /* and down              */
 
-static char *ssec_name[NUM_SSECS] = { "sec_A", "sec_B", "sec_C", "sec_D",
-				      "sec_E", "sec_F", "sec_G", "sec_H",
-				      "sec_I", "sec_J", "sec_K", "sec_L",
-				      "sec_M", "sec_N", "sec_O", "sec_P" };
+#define  MAX_NAME   64        /* of a sector, in the file names */
+#define  SECTOR_TAG 8         /* strlen("#SECTOR:")             */
+#define  READ_SIZE  (1 << 20) /* bytes read at a time           */
+#define  OUT_SIZE   (1 << 16) /* bytes buffered per output file */
 
-main(argc,argv)
-int argc;
-char *argv[];
+/*-- one of the 16 files of the sector being written --*/
+typedef struct _outfile {
+        int fd;
+        char name[MAX_NAME + 8];
+        char *buf;
+        int cnt;
+        } OutFile;
+
+static OutFile out[NUM_SSECS];
+void sector_close();
+static int sector_is_open = FALSE;
+static char *prog;
+static long skipped;
+static int failed = FALSE;
+
+/*-- the sector to open at its first world, if it has not been yet: the
+     name for the output files, the name for the titles, and whether a
+     '#SECTOR:' line named it (its files are made even if it has no worlds) --*/
+static char pend_name[MAX_NAME + 1], *pend_title;
+static int pending = FALSE, pend_marked;
+
+/*-- a tab delimited file: the fields its header line gives for the hex and
+     the sector (-1 if none), that line, and the last sector a line was in --*/
+static int hex_field = -1, sec_field = -1;
+static char *tab_head;
+static long tab_head_len;
+static char last_sec[MAX_NAME + 1];
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: out_flush, out_put                                              *
+ *                                                                           *
+ * Purpose:  Write what is buffered for output file 'o'; add 'len' bytes to  *
+ *           it, writing them straight out if they would not fit.  A write   *
+ *           error is reported once per file and the run then fails.         *
+ *                                                                           *
+ *****************************************************************************/
+
+static void out_write(o, p, len)
+OutFile *o;
+char *p;
+long len;
 {
-  int done, i, j, col, row, target, goodline;
-  char hex[10], str[10], ch, line[81], *status;
-  FILE *fd;
-  FILE *fd_out[NUM_SSECS];
+  long n;
 
-/*--- check invocation for correct parameter count ---*/
-  if (argc != 2) {
-      fprintf(stderr, "Usage: %s datafile \n", argv[0]);
-      exit(1); }
+  while ((len > 0) && (o->fd >= 0)) {
+    if ((n = write(o->fd, p, len)) < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "%s: Cannot write %s: %s\n", prog, o->name,
+		strerror(errno));
+      close(o->fd);
+      o->fd = -1;
+      failed = TRUE;
+      return;
+     }
+    p += n;
+    len -= n;
+   }
+}
 
-/*--- open the input file ---*/
-  fd = fopen(argv[1], "r");
-  if (fd == NULL) {
-      fprintf(stderr, "%s: Cannot open %s for input\n", argv[0], argv[1]);
-      exit(1); }
+void out_flush(o)
+OutFile *o;
+{
+  out_write(o, o->buf, (long) o->cnt);
+  o->cnt = 0;
+}
+
+void out_put(o, p, len)
+OutFile *o;
+char *p;
+long len;
+{
+  if (o->cnt + len > OUT_SIZE)
+    out_flush(o);
+  if (len >= OUT_SIZE)
+    out_write(o, p, len);
+  else {
+    memcpy(o->buf + o->cnt, p, len);
+    o->cnt += len;
+   }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: sector_open, sector_close                                       *
+ *                                                                           *
+ * Purpose:  Start the 16 files of a sector, '<name>_A' through '<name>_P',  *
+ *           each with its '@SUB-SECTOR: ... SECTOR: title' line and the     *
+ *           column header; finish them.  Returns FALSE if they cannot all   *
+ *           be made.                                                        *
+ *                                                                           *
+ *****************************************************************************/
+
+int sector_open(name, title)
+char *name, *title;
+{
+  char line[200];
+  int i, j;
 
-/*--- open the NUM_SSECS output files ---*/
+  sector_close();
   for (i=0; i<NUM_SSECS; i++) {
-    fd_out[i] = fopen(ssec_name[i], "w");
-    if (fd_out[i] == NULL) {
-      fprintf(stderr, "%s: Cannot open %s for output\n", argv[0], ssec_name[i]);
-      exit(1); }
+    sprintf(out[i].name, "%s_%c", name, 'A' + i);
+    if (out[i].buf == NULL)
+      out[i].buf = (char *) malloc(OUT_SIZE);
+    out[i].cnt = 0;
+    out[i].fd = -1;
+    if ((out[i].buf == NULL) ||
+	((out[i].fd = open(out[i].name, O_WRONLY | O_CREAT | O_TRUNC,
+		0666)) < 0)) {
+      fprintf(stderr, "%s: Cannot open %s for output\n", prog, out[i].name);
+      for (j=0; j<i; j++)
+        close(out[j].fd);
+      return (FALSE);
+     }
+    sprintf(line, "@SUB-SECTOR: %s   SECTOR: %.100s\n", out[i].name, title);
+    out_put(&out[i], line, (long) strlen(line));
+    for (j=0; j<8; j++) {
+      out_put(&out[i], header[j], (long) strlen(header[j]));
+      out_put(&out[i], "\n", 1L);
+     }
+    if (hex_field >= 0) {
+      out_put(&out[i], tab_head, tab_head_len);
+      out_put(&out[i], "\n", 1L);
+     }
    }
+  sector_is_open = TRUE;
+  return (TRUE);
+}
 
-/*--- print the SUB-SECTOR/SECTOR header for each output file ---*/
+void sector_close()
+{
+  int i;
+
+  if (!sector_is_open)
+    return;
   for (i=0; i<NUM_SSECS; i++) {
-    fprintf(fd_out[i], "@SUB-SECTOR: %s   SECTOR: %s\n",
-	ssec_name[i], argv[1]);
-    for (j=0; j<8; j++)
-      fprintf(fd_out[i], "%s\n", header[j]);
-   }
-
-/*--- Now, read each line in the full sector UWP file, one line at a   ---*/
-/*--- time.  Parse the 4-digit hex location code out of the line, and  ---*/
-/*--- determine which subsector file it should be written to.  Write   ---*/
-/*--- the line to the appropriate file.  Repeat the process until EOF. ---*/
-  done = FALSE;
-  while (!done) {
-    status = fgets(line, 81, fd);
-    if (status == NULL) break;
-
-/*--- make sure we're past the header lines ---*/
-    goodline = TRUE;
-/*--- If the line is shorter than 18 chars, it's a header line ---*/
-    if (strlen(line) < 18) goodline == FALSE;
-/*--- If the line is doesn't have digits in columns 14-18, ---*/
-/*--- it's a header line.                                  ---*/
-    for (i=14; i<18; i++)
-      if ((line[i] < '0') || (line[i] > '9')) goodline = FALSE;
-    if (!goodline) continue;
-
-/*--- get world hex location string ---*/
-    strncpy(hex, &line[14], 4);
-    hex[4] = NULL;
-
-/*--- convert string to digits ---*/
-    strncpy(str, hex, 2);
-    str[2] = NULL;
-/*--- determine which row and column the hex location is in ---*/
-    col = atoi(str);
-    strncpy(str, &(hex[2]), 2);
-    str[2] = NULL;
-    row = atoi(str);
-/*--- determine which subsector the row/column intersect in ---*/
-    target = (((row-1)/10)*4) + ((col-1)/8);
-
-/*--- write the line to that subsector file ---*/
-    fprintf(fd_out[target], "%s", line);
-   }
-  fclose(fd);
-  for (i=0; i<NUM_SSECS; i++)
-    fclose(fd_out[i]);
-  exit(0);
+    out_flush(&out[i]);
+    if ((out[i].fd >= 0) && (close(out[i].fd) != 0)) {
+      fprintf(stderr, "%s: Cannot write %s\n", prog, out[i].name);
+      failed = TRUE;
+     }
+   }
+  sector_is_open = FALSE;
+}
+
+/*-- make 'name' the next sector: the file names get its letters, digits,
+     '.', '-' and '_', anything else becoming '_', with any directory and
+     '.extension' dropped if it is a file name --*/
+static void sector_next(name, len, title, is_file)
+char *name, *title;
+int len, is_file;
+{
+  char *p;
+  int i, k;
+
+  if (is_file && (strcmp(name, "-") == 0)) {
+    name = "stdin";
+    len = 5;
+   }
+  else if (is_file) {
+    if ((p = strrchr(name, '/')) != NULL) {
+      len -= p + 1 - name;
+      name = p + 1;
+     }
+    if (((p = strrchr(name, '.')) != NULL) && (p > name))
+      len = p - name;
+   }
+  while ((len > 0) && (*name == ' ')) {
+    name++;
+    len--;
+   }
+  for (i=0, k=0; (i < len) && (k < MAX_NAME); i++)
+    if ((name[i] >= 'a' && name[i] <= 'z') || (name[i] >= 'A' && name[i] <= 'Z')
+	|| (name[i] >= '0' && name[i] <= '9') || (name[i] == '.') ||
+	(name[i] == '-') || (name[i] == '_'))
+      pend_name[k++] = name[i];
+    else if ((k > 0) && (pend_name[k-1] != '_'))
+      pend_name[k++] = '_';
+  while ((k > 0) && (pend_name[k-1] == '_'))
+    k--;
+  if (k == 0)
+    strcpy(pend_name, "sec");
+  else
+    pend_name[k] = '\0';
+  pend_title = title;
+  pending = TRUE;
+}
+
+/*-- start the sector called by the 'len' bytes at 'name', making the files
+     of the one before if a '#SECTOR:' line named it and it had no worlds --*/
+static void sector_start(name, len)
+char *name;
+long len;
+{
+  static char *title;
+  static long title_max;
+
+  if (pending && pend_marked && !sector_open(pend_name, pend_title))
+    failed = TRUE;
+  sector_close();
+/*--- the title is kept until the sector is done with ---*/
+  if (len >= title_max) {
+    title_max = len + 64;
+    if ((title = (char *) realloc(title, title_max)) == NULL) {
+      fprintf(stderr, "%s: Out of memory\n", prog);
+      exit(1); }
+   }
+  memcpy(title, name, len);
+  title[len] = '\0';
+  sector_next(title, (int) len, title, FALSE);
+  pend_marked = TRUE;
+}
+
+/*-- field 'f' of a tab delimited line, blanks trimmed: its length, with *q
+     set to its text, or -1 if the line has fewer fields --*/
+static long tab_field(p, len, f, q)
+char *p, **q;
+long len;
+int f;
+{
+  char *end = p + len, *tab;
+
+  for (; f > 0; f--) {
+    if ((tab = memchr(p, '\t', end - p)) == NULL)
+      return (-1);
+    p = tab + 1;
+   }
+  if ((tab = memchr(p, '\t', end - p)) != NULL)
+    end = tab;
+  while ((p < end) && (*p == ' '))
+    p++;
+  while ((end > p) && (end[-1] == ' '))
+    end--;
+  *q = p;
+  return (end - p);
+}
+
+/*-- take a tab delimited line as the header if it has a Hex column --*/
+static int tab_header(p, len)
+char *p;
+long len;
+{
+  char *q;
+  long n;
+  int f, hex = -1, sec = -1;
+
+  for (f=0; (n = tab_field(p, len, f, &q)) >= 0; f++) {
+    if ((n == 3) && (hex < 0) && (strncasecmp(q, "Hex", 3) == 0))
+      hex = f;
+    if ((n == 6) && (sec < 0) && (strncasecmp(q, "Sector", 6) == 0))
+      sec = f;
+   }
+  if (hex < 0)
+    return (FALSE);
+  if ((tab_head = (char *) realloc(tab_head, len + 1)) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", prog);
+    exit(1); }
+  memcpy(tab_head, p, len);
+  tab_head_len = len;
+  hex_field = hex;
+  sec_field = sec;
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  split_line                                                      *
+ *                                                                           *
+ * Purpose:  Hand one line ('len' bytes at 'p', without its newline) to the  *
+ *           file of its subsector: target = ((row-1)/10)*4 + (col-1)/8,     *
+ *           from the hex in columns 14-17, or in the Hex column of a tab    *
+ *           delimited (T5 SEC) file.  A line without four digits there is a *
+ *           header line and is dropped; one whose hex is not in the sector  *
+ *           is counted in 'skipped'.  '#SECTOR:' lines start a sector, as   *
+ *           does a change in the Sector column of a tab delimited file,     *
+ *           whose header line is copied to the top of each file after the   *
+ *           usual one.  '@' title lines are dropped, as their titles would  *
+ *           be the wrong ones for the subsectors.                           *
+ *                                                                           *
+ *****************************************************************************/
+
+void split_line(p, len)
+char *p;
+long len;
+{
+  int i, col, row, target, tab_row = FALSE;
+  char *h = NULL, *q;
+  long n;
+
+  if ((len > 0) && (p[len-1] == '\r'))
+    len--;
+  if ((len >= SECTOR_TAG) && (strncmp(p, "#SECTOR:", SECTOR_TAG) == 0)) {
+    sector_start(p + SECTOR_TAG, len - SECTOR_TAG);
+    return;
+   }
+  if ((len > 0) && (p[0] != '#') && (p[0] != '$') && (p[0] != '^') &&
+      (memchr(p, '\t', len) != NULL)) {
+    if ((hex_field >= 0) && (tab_field(p, len, hex_field, &h) == 4))
+      tab_row = TRUE;
+    else if (tab_header(p, len) || (hex_field >= 0))
+      return;
+    else
+      h = NULL;
+   }
+  if (!tab_row) {
+    if (len < 18)
+      return;
+    h = p + 14;
+   }
+  for (i=0; i<4; i++)
+    if ((h[i] < '0') || (h[i] > '9'))
+      return;
+  col = (h[0] - '0') * 10 + (h[1] - '0');
+  row = (h[2] - '0') * 10 + (h[3] - '0');
+  if ((col < 1) || (col > NUM_COLS) || (row < 1) || (row > NUM_ROWS)) {
+    skipped++;
+    return;
+   }
+  if (tab_row && (sec_field >= 0) &&
+      ((n = tab_field(p, len, sec_field, &q)) > 0)) {
+    if (n > MAX_NAME)
+      n = MAX_NAME;
+    if ((n != strlen(last_sec)) || (strncmp(q, last_sec, n) != 0)) {
+      memcpy(last_sec, q, n);
+      last_sec[n] = '\0';
+      sector_start(q, n);
+     }
+   }
+  if (pending) {
+    pending = FALSE;
+    if (!sector_open(pend_name, pend_title)) {
+      failed = TRUE;
+      skipped++;
+      return;
+     }
+   }
+  if (!sector_is_open) {
+    skipped++;
+    return;
+   }
+  target = (((row-1)/10)*4) + ((col-1)/8);
+  out_put(&out[target], p, len);
+  out_put(&out[target], "\n", 1L);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  split_file                                                      *
+ *                                                                           *
+ * Purpose:  Split the datafile 'name' ('-' for the standard input), READ_   *
+ *           SIZE bytes at a time.  A line cut by the end of a block is      *
+ *           moved to the front of the buffer and finished by the next read; *
+ *           the buffer grows for a line longer than itself.  Returns FALSE  *
+ *           if the file cannot be read.                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+int split_file(name)
+char *name;
+{
+  static char *buf;
+  static long size;
+  char *p, *nl, *end;
+  long have, n;
+  int fd;
+
+  if (strcmp(name, "-") == 0)
+    fd = 0;
+  else if ((fd = open(name, O_RDONLY)) < 0) {
+    fprintf(stderr, "%s: Cannot open %s for input\n", prog, name);
+    return (FALSE); }
+  if (buf == NULL) {
+    size = READ_SIZE;
+    if ((buf = (char *) malloc(size)) == NULL) {
+      fprintf(stderr, "%s: Out of memory\n", prog);
+      exit(1); }
+   }
+
+  hex_field = sec_field = -1;
+  last_sec[0] = '\0';
+  have = 0;
+  for (;;) {
+    if (have == size) {
+      size *= 2;
+      if ((buf = (char *) realloc(buf, size)) == NULL) {
+        fprintf(stderr, "%s: Out of memory\n", prog);
+        exit(1); }
+     }
+    if ((n = read(fd, buf + have, size - have)) < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "%s: Cannot read %s: %s\n", prog, name, strerror(errno));
+      break;
+     }
+    if (n == 0)
+      break;
+    end = buf + have + n;
+    for (p=buf; (nl = memchr(p, '\n', end - p)) != NULL; p=nl+1)
+      split_line(p, (long) (nl - p));
+    have = end - p;
+    memmove(buf, p, have);
+   }
+  if (have > 0)
+    split_line(buf, have);
+  if (fd != 0)
+    close(fd);
+  return (n == 0);
+}
+
+int main(argc,argv)
+int argc;
+char *argv[];
+{
+  int i;
+
+  prog = argv[0];
+
+/*--- check invocation for correct parameter count ---*/
+  if (argc < 2) {
+      fprintf(stderr, "Usage: %s datafile ... \n", argv[0]);
+      exit(1); }
+
+/*--- each file is a sector (sec_A.. if there is only one), and every ---*/
+/*--- '#SECTOR:' line in it starts another; the 16 files of a sector ---*/
+/*--- are made at its first world, or at the end of the file if it   ---*/
+/*--- has none, unless it is the file's own and a '#SECTOR:' line    ---*/
+/*--- came first                                                     ---*/
+  for (i=1; i<argc; i++) {
+    if (argc == 2)
+      sector_next("sec", 3, argv[i], FALSE);
+    else
+      sector_next(argv[i], strlen(argv[i]), argv[i], TRUE);
+    pend_marked = FALSE;
+    if (!split_file(argv[i]))
+      failed = TRUE;
+    if (pending && !sector_open(pend_name, pend_title))
+      failed = TRUE;
+    pending = FALSE;
+    sector_close();
+   }
+  if (skipped > 0)
+    fprintf(stderr, "%s: %ld lines with a hex outside 0101-3240 skipped\n",
+	prog, skipped);
+  exit(failed ? 1 : 0);
 }
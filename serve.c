@@ -0,0 +1,287 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       The render server ('--serve=socket').  One process
+ **                     listens on a Unix socket and prints a subsector for
+ **                     each connection, the way 'ssv -p' would, so a map
+ **                     costs only its parse and draw: the program is
+ **                     already started, the geometry and the fonts and
+ **                     base symbols at the last few scales asked for are
+ **                     already made, and the world, route and border
+ **                     arrays are already grown.
+ **
+ **                     A request is one line of options and a datafile:
+ **
+ **                       [-f format] [-z scale] [-a radius] [-o output] datafile
+ **
+ **                     A datafile of '-' is the rest of the connection (the
+ **                     client shuts down its side when it has sent it).
+ **                     The reply is a line, "OK" or "ERROR" and a reason,
+ **                     and without '-o' the OK is followed by the map
+ **                     itself.  Names are taken from the server's working
+ **                     directory.
+ **
+ **  File:              serve.c, containing the following subroutines:
+ **                       serve()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define MAX_WORDS    16       /* in a request line               */
+#define MAX_REQUEST  4096     /* bytes in a request line         */
+#define READ_SECS    10       /* a client that sends nothing for */
+                              /* this long is dropped            */
+
+static volatile sig_atomic_t serve_done;
+
+/*-- the request line and any datafile text sent after it --*/
+static char *req_text;
+static int req_max;
+static long req_size;
+
+static void serve_stop(sig)
+int sig;
+{
+  serve_done = TRUE;
+}
+
+/*-- read from 'fd' onto the end of req_text until there is a newline in
+     it past 'from' (or, if 'to_eof' is set, until the client is done);
+     FALSE if the read fails or times out --*/
+static int serve_read(fd, from, to_eof)
+int fd, to_eof;
+long from;
+{
+  long n;
+
+  for (;;) {
+    if (!to_eof && (memchr(req_text + from, '\n', req_size - from) != NULL))
+      return (TRUE);
+    if (!to_eof && (req_size > MAX_REQUEST))
+      return (FALSE);
+    req_text = grow(req_text, &req_max, req_size + 4096, 1);
+    n = read(fd, req_text + req_size, req_max - req_size);
+    if ((n < 0) && (errno == EINTR) && !serve_done)
+      continue;
+    if (n < 0)
+      return (FALSE);
+    if (n == 0)
+      return (to_eof);
+    req_size += n;
+   }
+}
+
+/*-- send the whole of 'msg' --*/
+static void serve_reply(fd, msg)
+int fd;
+char *msg;
+{
+  long n, len = strlen(msg);
+
+  while (len > 0) {
+    if ((n = write(fd, msg, len)) < 0) {
+      if (errno == EINTR) continue;
+      return;
+     }
+    msg += n;
+    len -= n;
+   }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  serve_request                                                   *
+ *                                                                           *
+ * Purpose:  Read a request from the client on 'fd', print the map and send  *
+ *           the reply.  Everything the options set is put back to what a    *
+ *           new process would have first, so no request sees another's.     *
+ *           'what' is set to the datafile, for the '-r' report.  Returns    *
+ *           FALSE if the request failed.                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+static int serve_request(fd, what)
+int fd;
+char **what;
+{
+  char *word[MAX_WORDS], *nl, *out_name, default_name[8];
+  long line, out_at;
+  int i, n, status;
+
+  *what = "?";
+  req_size = 0;
+  if (!serve_read(fd, 0L, FALSE)) {
+    serve_reply(fd, "ERROR no request\n");
+    return (FALSE); }
+  nl = memchr(req_text, '\n', req_size);
+  *nl = '\0';
+  line = nl - req_text + 1;
+  n = 0;
+  for (word[n] = strtok(req_text, " \t\r"); word[n] != NULL;
+       word[n] = strtok(NULL, " \t\r"))
+    if (++n == MAX_WORDS) {
+      serve_reply(fd, "ERROR too many words\n");
+      return (FALSE); }
+
+  out_format = FORMAT_XWD;
+  claim_radius = -1;
+  (void) set_scale(1.0);
+  out_name = NULL;
+  for (i=0; (i < n - 1) && (word[i][0] == '-') && (word[i][1] != '\0'); i+=2) {
+    if ((word[i][2] != '\0') || (i + 1 >= n - 1))
+      break;
+    if ((word[i][1] == 'f') &&
+        ((out_format = raster_format(word[i+1])) >= 0))
+      continue;
+    if ((word[i][1] == 'z') && set_scale(atof(word[i+1])))
+      continue;
+    if ((word[i][1] == 'a') && ((claim_radius = atoi(word[i+1])) >= 0))
+      continue;
+    if (word[i][1] == 'o') {
+      out_name = word[i+1];
+      continue;
+     }
+    break;
+   }
+  if (i != n - 1) {
+    serve_reply(fd, "ERROR bad request\n");
+    return (FALSE); }
+  *what = word[i];
+
+  title[0] = '\0';
+  if (strcmp(word[i], "-") == 0) {
+/*--- reading the datafile may move req_text, and the words with it ---*/
+    *what = "(sent)";
+    out_at = (out_name != NULL) ? out_name - req_text : -1;
+    if (!serve_read(fd, line, TRUE)) {
+      serve_reply(fd, "ERROR cannot read datafile\n");
+      return (FALSE); }
+    if (out_at >= 0)
+      out_name = req_text + out_at;
+    load_sector_text(req_text + line, req_size - line);
+   }
+  else if (!load_sector_file(word[i])) {
+    serve_reply(fd, "ERROR cannot read datafile\n");
+    return (FALSE); }
+
+  if (out_name != NULL) {
+    status = raster_print_subsector(out_name);
+    serve_reply(fd, status ? "OK\n" : "ERROR cannot write output\n");
+    return (status);
+   }
+  serve_reply(fd, "OK\n");
+  sprintf(default_name, "ssv%s", raster_extension());
+  out_fd = fd;
+  status = raster_print_subsector(default_name);
+  out_fd = -1;
+  return (status);
+}
+
+/*-- TRUE if 'name' is a socket nothing is listening on any more --*/
+static int stale_socket(name, addr)
+char *name;
+struct sockaddr_un *addr;
+{
+  struct stat st;
+  int fd, stale;
+
+  if ((lstat(name, &st) != 0) || !S_ISSOCK(st.st_mode))
+    return (FALSE);
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    return (FALSE);
+  stale = (connect(fd, (struct sockaddr *) addr, sizeof(*addr)) < 0) &&
+                (errno == ECONNREFUSED);
+  close(fd);
+  return (stale);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  serve                                                           *
+ *                                                                           *
+ * Purpose:  Listen on the Unix socket 'name' and answer requests one after  *
+ *           another until SIGINT or SIGTERM, then remove the socket.  A     *
+ *           socket left by a server that has gone is replaced.  Returns     *
+ *           FALSE if it cannot listen.  With '-r' each request is reported  *
+ *           on stderr with the time it took.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+int serve(name)
+char *name;
+{
+  struct sockaddr_un addr;
+  struct sigaction sa;
+  struct timeval start, end, limit;
+  char *what;
+  int sock, fd, status;
+
+  if (strlen(name) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "%s: Socket name \"%s\" is too long\n", program_name,
+                name);
+    return (FALSE); }
+  memset((char *) &addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, name);
+
+  if (stale_socket(name, &addr))
+    unlink(name);
+  if (((sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) ||
+      (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) ||
+      (listen(sock, SOMAXCONN) < 0)) {
+    fprintf(stderr, "%s: Cannot listen on \"%s\": %s\n", program_name, name,
+                strerror(errno));
+    return (FALSE); }
+
+/*--- no SA_RESTART, so a signal gets accept() out of its wait ---*/
+  memset((char *) &sa, 0, sizeof(sa));
+  sa.sa_handler = serve_stop;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  limit.tv_sec = READ_SECS;
+  limit.tv_usec = 0;
+  while (!serve_done) {
+    if ((fd = accept(sock, NULL, NULL)) < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "%s: accept: %s\n", program_name, strerror(errno));
+      break;
+     }
+    (void) setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (char *) &limit,
+                sizeof(limit));
+    gettimeofday(&start, NULL);
+    status = serve_request(fd, &what);
+    close(fd);
+    if (frame_stats) {
+      gettimeofday(&end, NULL);
+      fprintf(stderr, "%s: serve: %s%s, %.1f ms\n", program_name, what,
+                status ? "" : " failed", (end.tv_sec - start.tv_sec) * 1000.0 +
+                (end.tv_usec - start.tv_usec) / 1000.0);
+     }
+   }
+  close(sock);
+  unlink(name);
+  return (TRUE);
+}
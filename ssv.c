@@ -6,10 +6,26 @@
  **  File:              ssv.c, containing the following subroutines/functions:
  **                       main()
  **                       gen_sector()
+ **                       gen_sector_grid()
+ **                       gen_sector_borders()
+ **                       gen_sector_worlds()
+ **                       route_segment()
+ **                       display_parts()
+ **                       draw_world()
+ **                       draw_world_parts()
+ **                       grow()
+ **                       open_text()
+ **                       close_text()
  **                       load_sector_file()
+ **                       load_sector_text()
+ **                       read_sector_file()
+ **                       world_finish()
+ **                       parse_sector_line()
  **                       load_bdr_seg()
  **                       print_sector_file()
  **                       repaint_buttons()
+ **                       inspect()
+ **                       repaint_info()
  **                       mark_border()
  **                       print_subsector()
  **                       Get_Colors()
@@ -32,24 +48,12 @@
  **
  *****************************************************************************/
 
-#include <stdio.h>
-#include <X11/Xlib.h>
-#include <X11/Xutil.h>
-#include <X11/Xos.h>
+#include "ssv.h"
 #include <strings.h>
-
-/******************************
-#define NORMAL_FONT "hp8.8x16"
-#define BOLD_FONT   "hp8.8x16b"
-******************************/
-
-/*
-#define NORMAL_FONT "iso1.16"
-#define BOLD_FONT   "iso1.16b"
-*/
-#define NORMAL_FONT "8x13"
-#define BOLD_FONT   "8x13bold"
-#define SMALL_FONT  "6x10"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 /*****************************************************************************
  **
@@ -68,44 +72,17 @@
 #include "bitmaps/tlaukhu.xbm"
 #include "bitmaps/zhodane.xbm"
 
-/*****************************************************************************
- **
- **  This next typedef is lifted straight out of the xwd/xwud utility pair,
- **  and defines the file format used by them and the xpr print utility.
- **
- *****************************************************************************/
-
-typedef unsigned long imgval;
-
-#define XWD_FILE_VERSION    7
-
-typedef struct _img_file_header {
-        imgval header_size;       /* Size of the entire file header (bytes). */
-        imgval file_version;      /* FILE_VERSION */
-        imgval pixmap_format;     /* Pixmap format */
-        imgval pixmap_depth;      /* Pixmap depth */
-        imgval pixmap_width;      /* Pixmap width */
-        imgval pixmap_height;     /* Pixmap height */
-        imgval xoffset;           /* Bitmap x offset */
-        imgval byte_order;        /* MSBFirst, LSBFirst */
-        imgval bitmap_unit;       /* Bitmap unit */
-        imgval bitmap_bit_order;  /* MSBFirst, LSBFirst */
-        imgval bitmap_pad;        /* Bitmap scanline pad */
-        imgval bits_per_pixel;    /* Bits per pixel */
-        imgval bytes_per_line;    /* Bytes per scanline */
-        imgval visual_class;      /* Class of colormap */
-        imgval red_mask;          /* Z red mask */
-        imgval green_mask;        /* Z green mask */
-        imgval blue_mask;         /* Z blue mask */
-        imgval bits_per_rgb;      /* Log base 2 of distinct color values */
-        imgval colormap_entries;  /* Number of entries in colormap */
-        imgval ncolors;           /* Number of Color structures */
-        imgval window_width;      /* Window width */
-        imgval window_height;     /* Window height */
-        long window_x;            /* Window upper left X coordinate */
-        long window_y;            /* Window upper left Y coordinate */
-        imgval window_bdrwidth;   /* Window border width */
-} IMGFileHeader;
+Symbol base_sym[NUM_SYMS] = {
+        { naval1_bits,   naval1_width,   naval1_height   },
+        { naval2_bits,   naval2_width,   naval2_height   },
+        { scout1_bits,   scout1_width,   scout1_height   },
+        { scout2_bits,   scout2_width,   scout2_height   },
+        { depot_bits,    depot_width,    depot_height    },
+        { aslan_bits,    aslan_width,    aslan_height    },
+        { corsair_bits,  corsair_width,  corsair_height  },
+        { military_bits, military_width, military_height },
+        { tlaukhu_bits,  tlaukhu_width,  tlaukhu_height  },
+        { zhodane_bits,  zhodane_width,  zhodane_height  } };
 
 /*****************************************************************************
  **
@@ -114,201 +91,199 @@ typedef struct _img_file_header {
  **
  *****************************************************************************/
 
-#define sm_chex_width 16
-#define sm_chex_height 16
-static char sm_chex_bits[] = {
+char sm_chex_bits[] = {
    0x55, 0x55, 0xaa, 0xaa, 0x55, 0x55, 0xaa, 0xaa, 0x55, 0x55, 0xaa, 0xaa,
    0x55, 0x55, 0xaa, 0xaa, 0x55, 0x55, 0xaa, 0xaa, 0x55, 0x55, 0xaa, 0xaa,
    0x55, 0x55, 0xaa, 0xaa, 0x55, 0x55, 0xaa, 0xaa};
 
-#define  TRUE   1
-#define  FALSE  0
-
-#define  GARDEN   2
-#define  ASTEROID 1
-#define  DESERT   0
-
-typedef struct _worldstruct {
-        XPoint location;
-        int WorldType;
-        int GasGiant;
-        char Starport[2];
-        char Base[2];
-        char Zone[2];
-        char hex[5];
-        char name[21];
-	char uwp[9];
-	char notes[13];
-        char allegiance[3];
-        } World;
+XSegment *bdr_seg, *file_bdr_seg;
+Route *t_route;
+Border *file_bdr;
+World *sec_world;
+int w_max, tr_max;
+static int seg_max;
 
-XSegment t_route[80], bdr_seg[160], file_bdr_seg[160];
-World sec_world[80];
-
-char line[128], ch, title[80], program_name[40];
+char title[80], program_name[40];
 
 static char map_name[] = {"SUB-SECTOR"};
 static char panel_name[] = {"PANEL"};
+static char info_name[] = {"INSPECTOR"};
 static int DISP_ALL = 1;
 static int DISP_TRADE = 1;
 static int DISP_CODE = 1;
 
-#define NUM_HEX_PTS   7
-#define NUM_HEXES     8
-#define NUM_LINES    10
-#define LINE_INC    100
-
 #define BTN_WIDTH   100
 #define BTN_HEIGHT   20
 #define NUM_BTNS      7
 
-#define PAD          16
-#define HEX_PAD       4
-
 char *button_label[NUM_BTNS] = { "MARK BORDER", "CLEAR BORDER",
 	"PRINT MAP", "ALLEGIANCE", "TRADE CODES", "UWP", "QUIT" };
 
 int button_state[NUM_BTNS] = { FALSE, FALSE, FALSE, TRUE, TRUE, TRUE, FALSE };
 
-/****************************************************************************
- *  This array contains the list of hex centers (from left to right) with   *
- *  4 additional centers listed on either end of the row.  This allows X-   *
- *  boat routes to be drawn up to 4 hexes off to either side of the current *
- *  subsector map.                                                          *
- ****************************************************************************/
-
-static XPoint hex_ctr[NUM_HEXES+8] = {
-                {-290,  60},
-                {-200, 110},
-                {-110,  60},
-                { -20, 110},
-                {  70,  60},
-                { 160, 110},
-                { 250,  60},
-                { 340, 110},
-                { 430,  60},
-                { 520, 110},
-                { 610,  60},
-                { 700, 110},
-                { 790,  60},
-                { 880, 110},
-                { 970,  60},
-                {1060, 110} };
-
-/****************************************************************************
- *  The next values are the 6 points of each hex, arranged in CoordModePrev.*
- *  format.  The 1st value is filled in during each pass thru a double      *
- *  'for' loop.  The points are ordered as follows:      0_1                *
- *                                                     5/   \2              *
- *                                                      \4_3/               *
- ****************************************************************************/
-
-static XPoint hex_pts[NUM_HEX_PTS] = {
-                {  0,   0},
-                { 60,   0},
-                { 30,  50},
-                {-30,  50},
-                {-60,   0},
-                {-30, -50},
-                { 30, -50} };
-
-/****************************************************************************
- *  The next values are the 6 points of each hex, arranged in CoordModeAbs. *
- *  format (sort of).  Each point is an absolute value, relative to the     *
- *  0th [x,y] point in the array.  This is used for rendering static borders*
- *  loaded from the data file, rather than entered interactively.  The      *
- *  point ordering is the same as that in the hex_pts array (above).        *
- ****************************************************************************/
-
-static XPoint abs_hex_pts[NUM_HEX_PTS] = {
-                {  0,   0},
-                { 60,   0},
-                { 90,  50},
-                { 60, 100},
-                {  0, 100},
-                {-30,  50},
-                {  0,   0} };
-
-/****************************************************************************
- *  These values are the '0' point for each hex in a row (from left to      *
- *  right).  These values are substituted into the hex_pt array (above)     *
- *  as each hex is rendered.                                                *
- ****************************************************************************/
-
-static XPoint hex_loc[NUM_HEXES] = {
-                { 40, 10},
-                {130, 60},
-                {220, 10},
-                {310, 60},
-                {400, 10},
-                {490, 60},
-                {580, 10},
-                {670, 60} };
-
 Display       *dpy;
-Window         win, panel, button[NUM_BTNS];
+Window         win, panel, info, button[NUM_BTNS];
 GC             black_gc, white_gc, neg_gc, flicker_gc;
 int            w_cnt, tr_cnt, bdr_cnt, cur_bdr_cnt=0, arg_cnt;
 int            private_bdr_cnt, ScrDepth, print_only = FALSE;
-XFontStruct   *fptr, *fBptr, *fsptr;
-Pixmap         solid, chex, Naval1Pix, Naval2Pix;
-Pixmap         Scout1Pix, Scout2Pix, DepotPix;
-Pixmap         AslanPix, CorsairPix, MilPix, TlaukhuPix, ZhodanePix;
+int            frame_stats = FALSE;
+XFontStruct   *fptr;
+Pixmap         solid;
 unsigned long  black, white;
 XEvent         event;
 
-main(argc,argv)
+void print_sector_file(), repaint_buttons(), mark_border(), usage();
+int print_subsector(), Get_Colors();
+static void inspect();
+
+
+int main(argc,argv)
 int argc;
 char *argv[];
 {
   KeySym      key;
-  XSizeHints  xsh1, xsh2;
+  XSizeHints  xsh1, xsh2, xsh3;
   XSetWindowAttributes win_attrib;
   unsigned long w_a_mask;
-  int      screen, i, j, done;
-  int load_sector_file(), print_sector_file();
+  int      screen, i, j, done, batch = FALSE, jobs = 0;
+  int      sector_map = FALSE, have_view = FALSE;
+  int      split = FALSE, write_files = FALSE, route_jump = 0;
+  int      c1, r1, c2, r2, watch = FALSE, watch_fd = -1;
+  char    *out_name = NULL, *serve_name = NULL, default_name[8];
+  View     view;
   char   text[10];
 
   strcpy(program_name, argv[0]);
-
-  if ((argc > 3) || (argc < 2)) usage();
+  set_scale(1.0);
 
   arg_cnt = 1;
-  if (argc == 3) {
-    if (argv[1][0] != '-') usage();
-    if (argv[1][1] != 'p') usage();
-    print_only = TRUE;
-    arg_cnt = 2;
+  while ((arg_cnt < argc) && (argv[arg_cnt][0] == '-')) {
+    switch (argv[arg_cnt][1]) {
+      case 'p' : print_only = TRUE;
+                 break;
+      case 'b' : batch = TRUE;
+                 break;
+      case 'j' : if (++arg_cnt >= argc) usage();
+                 jobs = atoi(argv[arg_cnt]);
+                 break;
+      case 's' : sector_map = TRUE;
+                 break;
+      case 'x' : split = TRUE;
+                 break;
+      case 'w' : write_files = TRUE;
+                 break;
+      case 'v' : if (++arg_cnt >= argc) usage();
+                 if (sscanf(argv[arg_cnt], "%d,%d,%d,%d", &view.col, &view.row,
+                        &view.cols, &view.rows) != 4) usage();
+                 if ((view.cols <= 0) || (view.rows <= 0)) usage();
+                 view.col--;
+                 view.row--;
+                 have_view = TRUE;
+                 break;
+      case 'r' : frame_stats = TRUE;
+                 break;
+      case 't' : if (++arg_cnt >= argc) usage();
+                 if ((route_jump = atoi(argv[arg_cnt])) <= 0) usage();
+                 break;
+      case 'P' : if (++arg_cnt >= argc) usage();
+                 if (sscanf(argv[arg_cnt], "%d,%d,%d,%d", &c1, &r1, &c2,
+                        &r2) != 4) usage();
+                 route_between(c1 - 1, r1 - 1, c2 - 1, r2 - 1);
+                 break;
+      case 'a' : if (++arg_cnt >= argc) usage();
+                 if ((claim_radius = atoi(argv[arg_cnt])) < 0) usage();
+                 break;
+      case 'o' : if (++arg_cnt >= argc) usage();
+                 out_name = argv[arg_cnt];
+                 break;
+      case 'z' : if (++arg_cnt >= argc) usage();
+                 if (!set_scale(atof(argv[arg_cnt]))) usage();
+                 break;
+      case 'f' : if (++arg_cnt >= argc) usage();
+                 if ((out_format = raster_format(argv[arg_cnt])) < 0)
+                   usage();
+                 break;
+      case '-' : if (strcmp(argv[arg_cnt], "--stats") == 0)
+                   stats_enable(NULL);
+                 else if (strncmp(argv[arg_cnt], "--stats=", 8) == 0)
+                   stats_enable(&argv[arg_cnt][8]);
+                 else if (strcmp(argv[arg_cnt], "--watch") == 0)
+                   watch = TRUE;
+                 else if (strcmp(argv[arg_cnt], "--no-cache") == 0)
+                   cache_enabled = FALSE;
+                 else if (strncmp(argv[arg_cnt], "--serve=", 8) == 0)
+                   serve_name = &argv[arg_cnt][8];
+                 else
+                   usage();
+                 break;
+      default  : usage();
+     }
+    arg_cnt++;
    }
 
-  if (!load_sector_file(argc, argv)) {
+  if (out_name == NULL) {
+    sprintf(default_name, "ssv%s", raster_extension());
+    out_name = default_name;
+   }
+
+/*--- '--serve' renders datafiles on request until it is stopped ---*/
+  if (serve_name != NULL) {
+    if (arg_cnt != argc) usage();
+    exit(serve(serve_name) ? 0 : 1);
+   }
+
+/*--- '-b -x' splits one sector file and prints all 16 subsectors ---*/
+  if (batch && split) {
+    if (arg_cnt != argc - 1) usage();
+    exit(batch_split(argv[arg_cnt], jobs, write_files) ? 1 : 0);
+   }
+
+/*--- '-b' prints every datafile named (or sec_A..sec_P) and exits ---*/
+  if (batch)
+    exit(batch_print(argc - arg_cnt, &argv[arg_cnt], jobs) ? 1 : 0);
+
+/*--- '-t' prints jump routes as '$' lines and exits ---*/
+  if (route_jump) {
+    if (arg_cnt == argc) usage();
+    exit(route_print(argc - arg_cnt, &argv[arg_cnt], route_jump) ? 0 : 1);
+   }
+
+/*--- '-s' prints a whole sector, or several, and exits ---*/
+  if (sector_map) {
+    if (arg_cnt == argc) usage();
+    exit(map_print(argc - arg_cnt, &argv[arg_cnt], have_view ? &view : NULL,
+                out_name, jobs) ? 0 : 1);
+   }
+
+  if (arg_cnt != argc - 1) usage();
+
+  if (!load_sector_file(argv[arg_cnt])) {
       fprintf(stderr, "%s: Invalid datafile \"%s\"\n", argv[0], argv[arg_cnt]);
       exit(1); }
 
+/*--- '-p' never needs the server: draw into a client-side framebuffer ---*/
+  if (print_only) {
+    if (!raster_print_subsector(out_name)) {
+      fprintf(stderr, "%s: Cannot write \"%s\"\n", argv[0], out_name);
+      exit(1); }
+    exit(0);
+   }
+
   if ((dpy = XOpenDisplay(NULL)) == NULL) {
-      fprintf(stderr, "%s: Cannot open %s\n", argv[0], XDisplayName(NULL));
+      fprintf(stderr, "%s: Cannot open %s\n", argv[0], XDisplayName(NULL)[0] ?
+                XDisplayName(NULL) : "a display (DISPLAY is not set)");
       exit(1); }
 
   ScrDepth = XDefaultDepth(dpy, DefaultScreen(dpy));
 
-  fptr = XLoadQueryFont(dpy, NORMAL_FONT);
-  if (fptr == NULL) {
-      fprintf(stderr, "%s: Cannot open font \"%s\"\n", argv[0],NORMAL_FONT);
-      exit(1); }
-  fBptr = XLoadQueryFont(dpy, BOLD_FONT);
-  if (fBptr == NULL) {
-      fprintf(stderr, "%s: Cannot open font \"%s\"\n", argv[0],BOLD_FONT);
-      exit(1); }
-  fsptr = XLoadQueryFont(dpy, SMALL_FONT);
-  if (fsptr == NULL) {
-      fprintf(stderr, "%s: Cannot open font \"%s\"\n", argv[0],SMALL_FONT);
-      exit(1); }
+  if (!x_setup(DefaultRootWindow(dpy)))
+    exit(1);
 
   screen = DefaultScreen(dpy);
   black = BlackPixel(dpy, screen);    white = WhitePixel(dpy, screen);
 
   xsh1.flags  = (PPosition | PSize);
-  xsh1.height = 1070+PAD;    xsh1.width  = 770;
+  xsh1.height = MAP_HEIGHT;  xsh1.width  = MAP_WIDTH;
   xsh1.x      = 10;          xsh1.y      = 10;
 
   win = XCreateSimpleWindow(dpy, DefaultRootWindow(dpy),
@@ -334,19 +309,24 @@ char *argv[];
     button[i] = XCreateSimpleWindow(dpy, panel, 5, ((BTN_HEIGHT+5)*i)+5,
 		BTN_WIDTH, BTN_HEIGHT, 1, black, white);
 
-  black_gc   = XCreateGC(dpy, win, 0, 0);
-  white_gc   = XCreateGC(dpy, win, 0, 0);
+  xsh3.flags  = (PPosition | PSize);
+  xsh3.x      = 10;
+  xsh3.y      = xsh2.y + xsh2.height + 40;
+  xsh3.width  = INFO_WIDTH * XTextWidth(fptr, "M", 1) + 10;
+  xsh3.height = NUM_INFO * (fptr->ascent + fptr->descent) + 10;
+
+  info = XCreateSimpleWindow(dpy, DefaultRootWindow(dpy),
+                              xsh3.x, xsh3.y, xsh3.width,
+                              xsh3.height, 1, black, white);
+
+  XSetStandardProperties(dpy, info, info_name, info_name, None, argv,
+                        argc, &xsh3);
+
   neg_gc     = XCreateGC(dpy, win, 0, 0);
   flicker_gc = XCreateGC(dpy, win, 0, 0);
 
-  XSetFont(dpy, black_gc, fptr->fid);
-  XSetFont(dpy, white_gc, fptr->fid);
   XSetFont(dpy, neg_gc, fptr->fid);
 
-  XSetForeground(dpy, black_gc, black);
-  XSetBackground(dpy, black_gc, white);
-  XSetForeground(dpy, white_gc, white);
-  XSetBackground(dpy, white_gc, black);
   XSetForeground(dpy, flicker_gc, black);
   XSetBackground(dpy, flicker_gc, white);
   XSetForeground(dpy, neg_gc, white);
@@ -356,55 +336,32 @@ char *argv[];
   XSetLineAttributes(dpy, flicker_gc, 1, LineSolid, CapButt, JoinMiter);
   XSetPlaneMask(dpy, flicker_gc, 1);
 
-  chex  = XCreatePixmapFromBitmapData(dpy, win, sm_chex_bits,
-                sm_chex_width, sm_chex_height, white, black, ScrDepth);
-
-  XSetTile(dpy, black_gc, chex);
-  XSetTile(dpy, white_gc, chex);
-
-  Naval1Pix = XCreatePixmapFromBitmapData(dpy, win, naval1_bits, naval1_width,
-                naval1_height, black, white, ScrDepth);
-  Naval2Pix = XCreatePixmapFromBitmapData(dpy, win, naval2_bits, naval2_width,
-                naval2_height, black, white, ScrDepth);
-  Scout1Pix = XCreatePixmapFromBitmapData(dpy, win, scout1_bits, scout1_width,
-                scout1_height, black, white, ScrDepth);
-  Scout2Pix = XCreatePixmapFromBitmapData(dpy, win, scout2_bits, scout2_width,
-                scout2_height, black, white, ScrDepth);
-  DepotPix  = XCreatePixmapFromBitmapData(dpy, win, depot_bits, depot_width,
-                depot_height, black, white, ScrDepth);
-  AslanPix  = XCreatePixmapFromBitmapData(dpy, win, aslan_bits, aslan_width,
-                aslan_height, black, white, ScrDepth);
-  CorsairPix = XCreatePixmapFromBitmapData(dpy, win, corsair_bits,
-                corsair_width, corsair_height, black, white, ScrDepth);
-  MilPix    = XCreatePixmapFromBitmapData(dpy, win, military_bits,
-                military_width, military_height, black, white, ScrDepth);
-  TlaukhuPix = XCreatePixmapFromBitmapData(dpy, win, tlaukhu_bits,
-                tlaukhu_width, tlaukhu_height, black, white, ScrDepth);
-  ZhodanePix = XCreatePixmapFromBitmapData(dpy, win, zhodane_bits,
-                zhodane_width, zhodane_height, black, white, ScrDepth);
-
   done = FALSE;
-  if (print_only) {
-    print_subsector();
-    done = TRUE;
-   }
-  else {
-    XSelectInput(dpy, win, ButtonPressMask | PointerMotionMask |
-                        KeyPressMask | ExposureMask);
-    for (j=0;j<NUM_BTNS;j++)
-      XSelectInput(dpy, button[j], ButtonPressMask | ExposureMask);
-    XMapWindow(dpy, win);
-    XMapSubwindows(dpy, panel);
-    XMapWindow(dpy, panel);
-   }
+  XSelectInput(dpy, win, ButtonPressMask | PointerMotionMask |
+                      KeyPressMask | ExposureMask);
+  for (j=0;j<NUM_BTNS;j++)
+    XSelectInput(dpy, button[j], ButtonPressMask | ExposureMask);
+  XSelectInput(dpy, info, ExposureMask);
+  XMapWindow(dpy, win);
+  XMapSubwindows(dpy, panel);
+  XMapWindow(dpy, panel);
+  XMapWindow(dpy, info);
+
+  if (watch && ((watch_fd = watch_start(argv[arg_cnt])) < 0))
+    fprintf(stderr, "%s: Cannot watch \"%s\"\n", argv[0], argv[arg_cnt]);
 
   while (!done) {
+      if (watch_fd >= 0)
+        watch_wait(watch_fd, argv[arg_cnt]);
       XNextEvent(dpy, &event);
       switch (event.type) {
         case Expose:
+              if (event.xexpose.window == win)
+                layer_damage(event.xexpose.x, event.xexpose.y,
+                        event.xexpose.width, event.xexpose.height);
               if (event.xexpose.count == 0) {
                 if (event.xexpose.window == win)
-                  gen_sector(win);
+                  layer_repair(win, display_parts());
                 if ((event.xexpose.window == button[0]) ||
                     (event.xexpose.window == button[1]) ||
                     (event.xexpose.window == button[2]) ||
@@ -413,20 +370,28 @@ char *argv[];
                     (event.xexpose.window == button[5]) ||
                     (event.xexpose.window == button[6]))
                   repaint_buttons();
+                if (event.xexpose.window == info)
+                  repaint_info();
                }
               break;
+        case MotionNotify:
+              if (event.xmotion.window == win)
+                inspect(event.xmotion.x, event.xmotion.y);
+              break;
         case MappingNotify:
-              XRefreshKeyboardMapping ( &event);
+              XRefreshKeyboardMapping ( &event.xmapping);
               break;
         case ButtonPress:
-              if (event.xbutton.window == button[0])
+              if (event.xbutton.window == win)
+                inspect(event.xbutton.x, event.xbutton.y);
+              else if (event.xbutton.window == button[0])
                 mark_border();
               else if (event.xbutton.window == button[1]) {
                 button_state[1] = TRUE;
                 repaint_buttons();
-                XClearWindow(dpy, win);
                 bdr_cnt = cur_bdr_cnt;
-                gen_sector(win);
+                layer_invalidate(LAYER_BORDERS);
+                layer_show(win, display_parts());
                 button_state[1] = FALSE;
                 repaint_buttons();
                }
@@ -435,22 +400,19 @@ char *argv[];
               else if (event.xbutton.window == button[3]) {
 		DISP_ALL = 1-DISP_ALL;
 		button_state[3] = DISP_ALL;
-                XClearWindow(dpy, win);
-                gen_sector(win);
+                layer_show(win, display_parts());
                 repaint_buttons();
 		}
               else if (event.xbutton.window == button[4]) {
 		DISP_TRADE = 1-DISP_TRADE;
 		button_state[4] = DISP_TRADE;
-                XClearWindow(dpy, win);
-                gen_sector(win);
+                layer_show(win, display_parts());
                 repaint_buttons();
 		}
               else if (event.xbutton.window == button[5]) {
 		DISP_CODE = 1-DISP_CODE;
 		button_state[5] = DISP_CODE;
-                XClearWindow(dpy, win);
-                gen_sector(win);
+                layer_show(win, display_parts());
                 repaint_buttons();
 		}
               else if (event.xbutton.window == button[6]) {
@@ -460,394 +422,681 @@ char *argv[];
                }
               break;
         case KeyPress:
-              i = XLookupString(&event, text, 10, &key, NULL);
+              i = XLookupString(&event.xkey, text, 10, &key, NULL);
               if (i == 1 && text[0] == 'q') done++;
               break;
       } /* switch */
   } /* while (!done) */
   XDestroyWindow(dpy, win);
   XDestroyWindow(dpy, panel);
+  XDestroyWindow(dpy, info);
   XCloseDisplay(dpy);
   exit(0);
 }
 
-gen_sector(d)
-Drawable d;
+/*****************************************************************************
+ *                                                                           *
+ * Routines: gen_sector, gen_sector_grid, gen_sector_borders,                *
+ *           gen_sector_worlds                                               *
+ *                                                                           *
+ * Purpose:  Draw the subsector map.  The steps are also callable one at a   *
+ *           time, so layer.c can keep each one in a pixmap of its own.      *
+ *           Each step draws only what sector_find() returns: everything,    *
+ *           or just what meets sector_area when a damaged part of the map   *
+ *           is being repaired (the device is then clipped to it).           *
+ *                                                                           *
+ *****************************************************************************/
+
+void gen_sector(dev)
+Device *dev;
 {
-  int i, j, x_ctr, y_ctr, x, y, len;
-  short x1, y1, x2, y2;
-  World *w;
+  gen_sector_grid(dev);
+  gen_sector_borders(dev);
+  gen_sector_worlds(dev, display_parts());
+}
 
-/*--- Step 1: generate the trade-routes within the grid ---*/
-  XSetLineAttributes(dpy, black_gc, 5, LineSolid, CapRound, JoinMiter);
-  for (i=0; i<tr_cnt; i++) {
-    x1 = t_route[i].x1;
-    y1 = t_route[i].y1;
-    x2 = t_route[i].x2;
-    y2 = t_route[i].y2;
-    y1 = hex_ctr[x1+HEX_PAD].y + (y1 * LINE_INC);
-    x1 = hex_ctr[x1+HEX_PAD].x;
-    y2 = hex_ctr[x2+HEX_PAD].y + (y2 * LINE_INC);
-    x2 = hex_ctr[x2+HEX_PAD].x;
-    if ((x1 > -5000) && (x1 < 5000) &&
-        (y1 > -5000) && (y1 < 5000) &&
-        (x2 > -5000) && (x2 < 5000) &&
-        (y2 > -5000) && (y2 < 5000))
-      XDrawLine(dpy, d, black_gc, x1, y1+PAD, x2, y2+PAD);
+/*-- where route 'rt' is drawn; FALSE if it is too far off the map --*/
+int route_segment(rt, seg)
+Route *rt;
+XSegment *seg;
+{
+  int x1, y1, x2, y2;
+
+  y1 = hex_ctr[rt->x1+HEX_PAD].y + (rt->y1 * LINE_INC);
+  x1 = hex_ctr[rt->x1+HEX_PAD].x;
+  y2 = hex_ctr[rt->x2+HEX_PAD].y + (rt->y2 * LINE_INC);
+  x2 = hex_ctr[rt->x2+HEX_PAD].x;
+  if ((x1 > -5000) && (x1 < 5000) &&
+      (y1 > -5000) && (y1 < 5000) &&
+      (x2 > -5000) && (x2 < 5000) &&
+      (y2 > -5000) && (y2 < 5000)) {
+    seg->x1 = x1;
+    seg->y1 = y1 + PAD;
+    seg->x2 = x2;
+    seg->y2 = y2 + PAD;
+    return (TRUE);
    }
-  XFlush(dpy);
-  XSetLineAttributes(dpy, black_gc, 1, LineSolid, CapButt, JoinMiter);
+  return (FALSE);
+}
+
+void gen_sector_grid(dev)
+Device *dev;
+{
+  int i, n, len, *item;
+  XSegment seg;
+  double start;
+
+/*--- Step 1: generate the trade-routes within the grid ---*/
+  start = stats_clock();
+  (*dev->pen)(dev, S(5), CapRound, FillSolid);
+  n = sector_find(dev, ITEM_ROUTE, &item);
+  for (i=0; i<n; i++)
+    if (route_segment(&t_route[item[i]], &seg))
+      (*dev->line)(dev, seg.x1, seg.y1, seg.x2, seg.y2);
+  (*dev->flush)(dev);
+  (*dev->pen)(dev, 1, CapButt, FillSolid);
+  stats_time(STAT_ROUTES, start);
 
 /*--- Step 2: generate the empty grid ---*/
-  XFillRectangle(dpy, d, white_gc, 0, 0, 770, 10+PAD);
-  XFillRectangle(dpy, d, white_gc, 0, 0, 10, 1070+PAD);
-  XFillRectangle(dpy, d, white_gc, 0, 1060+PAD, 770, 10); 
-  XFillRectangle(dpy, d, white_gc, 760, 0, 10, 1070); 
-  XSetLineAttributes(dpy, black_gc, 0, LineSolid, CapButt, JoinMiter);
-  for (i=0; i<NUM_LINES*LINE_INC; i+=LINE_INC) {
-    for (j=0; j<NUM_HEXES; j++) {
-      hex_pts[0].x = hex_loc[j].x;
-      hex_pts[0].y = hex_loc[j].y + i + PAD;
-      XDrawLines(dpy, d, black_gc, hex_pts, NUM_HEX_PTS, CoordModePrevious);
-     }
+  start = stats_clock();
+  (*dev->fill_rect)(dev, PAPER, 0, 0, MAP_WIDTH, S(10)+PAD);
+  (*dev->fill_rect)(dev, PAPER, 0, 0, S(10), MAP_HEIGHT);
+  (*dev->fill_rect)(dev, PAPER, 0, MAP_HEIGHT-S(10), MAP_WIDTH, S(10));
+  (*dev->fill_rect)(dev, PAPER, MAP_WIDTH-S(10), 0, S(10), MAP_HEIGHT-PAD);
+  (*dev->pen)(dev, 0, CapButt, FillSolid);
+  n = sector_find(dev, ITEM_HEX, &item);
+  for (i=0; i<n; i++) {
+    hex_pts[0].x = hex_loc[item[i] % NUM_HEXES].x;
+    hex_pts[0].y = hex_loc[item[i] % NUM_HEXES].y +
+                (item[i] / NUM_HEXES) * LINE_INC + PAD;
+    (*dev->lines)(dev, hex_pts, NUM_HEX_PTS, CoordModePrevious);
    }
-  XDrawLine(dpy, d, black_gc, 730, 60+PAD, 760, 10+PAD);
-  XDrawLine(dpy, d, black_gc, 40, 1010+PAD, 10, 1060+PAD);
-  XSetLineAttributes(dpy, black_gc, 3, LineSolid, CapButt, JoinMiter);
-  XDrawRectangle(dpy, d, black_gc, 10, 10+PAD, 750, 1050); 
-  XSetLineAttributes(dpy, black_gc, 1, LineSolid, CapButt, JoinMiter);
+  (*dev->line)(dev, hex_ctr[HEX_PAD+NUM_HEXES-1].x+S(30), hex_ctr[0].y+PAD,
+                hex_ctr[HEX_PAD+NUM_HEXES-1].x+S(60), S(10)+PAD);
+  (*dev->line)(dev, hex_loc[0].x, hex_loc[0].y+NUM_LINES*LINE_INC+PAD,
+                S(10), MAP_HEIGHT-S(10));
+  (*dev->pen)(dev, S(3), CapButt, FillSolid);
+  (*dev->draw_rect)(dev, S(10), S(10)+PAD, MAP_WIDTH-2*S(10),
+                MAP_HEIGHT-PAD-2*S(10));
+  (*dev->pen)(dev, 1, CapButt, FillSolid);
   /*--- Print the sector/subsector title ---*/
-  len = XTextWidth(fptr, title, strlen(title)-1); 
-  XSetFont(dpy, black_gc, fBptr->fid);
-  XDrawImageString(dpy, d, black_gc, (770-len)/2, 16, title, strlen(title)-1);
-  XSetFont(dpy, black_gc, fptr->fid);
-  XFlush(dpy);
+  len = (*dev->width)(dev, FONT_NORMAL, title, strlen(title)-1); 
+  (*dev->font)(dev, FONT_BOLD);
+  (*dev->text)(dev, (MAP_WIDTH-len)/2, S(16), title, strlen(title)-1);
+  (*dev->font)(dev, FONT_NORMAL);
+  (*dev->flush)(dev);
+  stats_time(STAT_GRID, start);
+}
+
+void gen_sector_borders(dev)
+Device *dev;
+{
+  int i, n, *item;
+  BdrLine *l;
+  double start;
 
 /*--- Step 3: if zone borders exist, generate them ---*/
+  start = stats_clock();
   if (bdr_cnt || private_bdr_cnt) {
-    XSetFillStyle(dpy, black_gc, FillTiled);
-    XSetLineAttributes(dpy, black_gc, 5, LineSolid, CapButt, JoinMiter);
-    if (bdr_cnt)
-      for (i=0; i<bdr_cnt; i++)
-        XDrawLine(dpy, d, black_gc, bdr_seg[i].x1, bdr_seg[i].y1,
-                                bdr_seg[i].x2, bdr_seg[i].y2);
-    if (private_bdr_cnt)
-      XDrawSegments(dpy, d, black_gc, file_bdr_seg, private_bdr_cnt);
-    XSetFillStyle(dpy, black_gc, FillSolid);
-    XSetLineAttributes(dpy, black_gc, 1, LineSolid, CapButt, JoinMiter);
+    (*dev->pen)(dev, S(5), CapButt, FillTiled);
+    n = sector_find(dev, ITEM_BORDER, &item);
+    for (i=0; i<n; i++)
+      (*dev->line)(dev, bdr_seg[item[i]].x1, bdr_seg[item[i]].y1,
+                              bdr_seg[item[i]].x2, bdr_seg[item[i]].y2);
+    n = sector_find(dev, ITEM_FILE_BORDER, &item);
+    for (i=0; i<n; i++) {
+      l = &file_bdr_line[item[i]];
+      (*dev->lines)(dev, &file_bdr_pts[l->first], l->npoints, CoordModeOrigin);
+     }
+    (*dev->pen)(dev, 1, CapButt, FillSolid);
+    (*dev->flush)(dev);
    }
+  stats_time(STAT_BORDERS, start);
+}
+
+/*-- 'parts' says which of each world's WORLD_... parts to draw --*/
+void gen_sector_worlds(dev, parts)
+Device *dev;
+int parts;
+{
+  int i, n, x, y, x_ctr, y_ctr, *item;
+  World *w;
+  double start;
 
 /*--- Step 4: generate each system within the grid ---*/
-  for (i=0; i<w_cnt; i++) {
-    w = &sec_world[i];
+  start = stats_clock();
+  n = sector_find(dev, ITEM_WORLD, &item);
+  for (i=0; i<n; i++) {
+    w = &sec_world[item[i]];
     x = w->location.x;
     y = w->location.y;
     x_ctr = hex_ctr[x+HEX_PAD].x;
     y_ctr = hex_ctr[x+HEX_PAD].y + (y * LINE_INC);
+    draw_world_parts(dev, w, x_ctr, y_ctr, parts);
+   }
+  (*dev->flush)(dev);
+  stats_time(STAT_WORLDS, start);
+}
 
-    if (w->Zone[0] == 'R') {
-      XSetFillStyle(dpy, black_gc, FillTiled);
-      XFillArc(dpy, d, black_gc, x_ctr-45, y_ctr-45+PAD, 90, 90, 0, 360*64);
-      XSetFillStyle(dpy, black_gc, FillSolid);
-     }
-    if (w->Zone[0] == 'A') {
-      XSetFillStyle(dpy, black_gc, FillTiled);
-      XSetLineAttributes(dpy, black_gc, 5, LineSolid, CapButt, JoinMiter);
-      XDrawArc(dpy, d, black_gc, x_ctr-45, y_ctr-45+PAD, 90, 90, 0, 360*64);
-      XSetFillStyle(dpy, black_gc, FillSolid);
-      XSetLineAttributes(dpy, black_gc, 1, LineSolid, CapButt, JoinMiter);
-     }
+/*****************************************************************************
+ *                                                                           *
+ * Routines: draw_world, draw_world_parts, display_parts                     *
+ *                                                                           *
+ * Purpose:  Draw one star system (zone, world disc, gas giant, base symbols *
+ *           and labels) centered on [x_ctr, y_ctr+PAD].  Shared by the      *
+ *           subsector map (gen_sector) and the sector map (gen_map).        *
+ *           draw_world_parts() draws only the WORLD_... parts asked for,    *
+ *           in the same order; draw_world() draws the symbol and whichever  *
+ *           labels the ALLEGIANCE, TRADE CODES and UWP buttons have on      *
+ *           (display_parts).                                                *
+ *                                                                           *
+ *****************************************************************************/
 
-    XFillArc(dpy, d, white_gc, x_ctr-12, y_ctr-15+PAD, 24, 24, 0, 360*64);
-    if (w->WorldType == DESERT) {
-      XSetLineAttributes(dpy, black_gc, 2, LineSolid, CapButt, JoinMiter);
-      XDrawArc(dpy, d, black_gc, x_ctr-10, y_ctr-13+PAD, 20, 20, 0, 360*64);
-      XSetLineAttributes(dpy, black_gc, 1, LineSolid, CapButt, JoinMiter);
-     }
-    else if (w->WorldType == GARDEN)
-      XFillArc(dpy, d, black_gc, x_ctr-10, y_ctr-13+PAD, 20, 20, 0, 360*64);
-    else {
-      XFillArc(dpy, d, black_gc, x_ctr-8, y_ctr-11+PAD, 5, 5, 0, 360*64);
-      XFillArc(dpy, d, black_gc, x_ctr,   y_ctr-7+PAD, 5, 5, 0, 360*64);
-      XFillArc(dpy, d, black_gc, x_ctr-8, y_ctr-3+PAD,   5, 5, 0, 360*64);
-      XFillArc(dpy, d, black_gc, x_ctr+2, y_ctr-1+PAD, 5, 5, 0, 360*64);
-     }
+int display_parts()
+{
+  return (WORLD_SYMBOL | (DISP_ALL ? WORLD_ALLEGIANCE : 0) |
+                (DISP_TRADE ? WORLD_TRADE : 0) | (DISP_CODE ? WORLD_UWP : 0));
+}
 
-    if (w->GasGiant) {
-      XFillArc(dpy, d, white_gc, x_ctr+26, y_ctr-30+PAD, 13, 13, 0, 360*64);
-      XFillArc(dpy, d, black_gc, x_ctr+28, y_ctr-28+PAD, 9, 9, 0, 360*64);
-     }
+void draw_world(dev, w, x_ctr, y_ctr)
+Device *dev;
+World *w;
+int x_ctr, y_ctr;
+{
+  draw_world_parts(dev, w, x_ctr, y_ctr, display_parts());
+}
+
+/*-- the zone, world disc, gas giant, bases, hex number and starport --*/
+static void draw_world_symbol(dev, w, l, x_ctr, y_ctr)
+Device *dev;
+World *w;
+Label *l;
+int x_ctr, y_ctr;
+{
+  if (w->Zone[0] == 'R') {
+    (*dev->pen)(dev, 1, CapButt, FillTiled);
+    (*dev->fill_arc)(dev, INK, x_ctr-S(45), y_ctr-S(45)+PAD, S(90), S(90));
+    (*dev->pen)(dev, 1, CapButt, FillSolid);
+   }
+  if (w->Zone[0] == 'A') {
+    (*dev->pen)(dev, S(5), CapButt, FillTiled);
+    (*dev->draw_arc)(dev, x_ctr-S(45), y_ctr-S(45)+PAD, S(90), S(90));
+    (*dev->pen)(dev, 1, CapButt, FillSolid);
+   }
 
-    switch(w->Base[0]) {
-      case 'A'  : XCopyArea(dpy, Naval1Pix, d, black_gc, 0, 0,
-                        naval2_width, naval2_height, x_ctr-35, y_ctr-20+PAD);
-                  XCopyArea(dpy, Scout1Pix, d, black_gc, 0, 0,
-                        scout1_width, scout1_height, x_ctr-35, y_ctr-4+PAD);
-                  break;
-      case 'B'  : XCopyArea(dpy, Naval1Pix, d, black_gc, 0, 0,
-                        naval2_width, naval2_height, x_ctr-35, y_ctr-20+PAD);
-                  XCopyArea(dpy, Scout2Pix, d, black_gc, 0, 0,
-                        scout2_width, scout2_height, x_ctr-35, y_ctr-4+PAD);
-                  break;
-      case 'C'  : XCopyArea(dpy, CorsairPix, d, black_gc, 0, 0,
-                        corsair_width, corsair_height, x_ctr-35, y_ctr-4+PAD);
-                  break;
-      case 'D'  : XCopyArea(dpy, DepotPix, d, black_gc, 0, 0,
-                        depot_width, depot_height, x_ctr-35, y_ctr-20+PAD);
-                  break;
-      case 'H'  : XCopyArea(dpy, CorsairPix, d, black_gc, 0, 0,
-                        corsair_width, corsair_height, x_ctr-35, y_ctr-4+PAD);
-      case 'F'  :
-      case 'G'  :
-      case 'J'  : XCopyArea(dpy, Naval2Pix, d, black_gc, 0, 0,
-                        naval2_width, naval2_height, x_ctr-35, y_ctr-20+PAD);
-                  break;
-      case 'M'  : XCopyArea(dpy, MilPix, d, black_gc, 0, 0,
-                        military_width, military_height, x_ctr-35, y_ctr-4+PAD);
-                  break;
-      case 'N'  : XCopyArea(dpy, Naval1Pix, d, black_gc, 0, 0,
-                        naval1_width, naval1_height, x_ctr-35, y_ctr-20+PAD);
-                  break;
-      case 'R'  : XCopyArea(dpy, AslanPix, d, black_gc, 0, 0,
-                        aslan_width, aslan_height, x_ctr-35, y_ctr-20+PAD);
-                  break;
-      case 'S'  : XCopyArea(dpy, Scout1Pix, d, black_gc, 0, 0,
-                        scout1_width, scout1_height, x_ctr-35, y_ctr-20+PAD);
-                  break;
-      case 'T'  : XCopyArea(dpy, TlaukhuPix, d, black_gc, 0, 0,
-                        tlaukhu_width, tlaukhu_height, x_ctr-35, y_ctr-4+PAD);
-                  break;
-      case 'W'  : XCopyArea(dpy, Scout2Pix, d, black_gc, 0, 0,
-                        scout2_width, scout2_height, x_ctr-35, y_ctr-20+PAD);
-                  break;
-      case 'Z'  : XCopyArea(dpy, ZhodanePix, d, black_gc, 0, 0,
-                        zhodane_width, zhodane_height, x_ctr-35, y_ctr-20+PAD);
-      default   : break;
+  (*dev->fill_arc)(dev, PAPER, x_ctr-S(12), y_ctr-S(15)+PAD, S(24), S(24));
+  if (w->WorldType == DESERT) {
+    (*dev->pen)(dev, S(2), CapButt, FillSolid);
+    (*dev->draw_arc)(dev, x_ctr-S(10), y_ctr-S(13)+PAD, S(20), S(20));
+    (*dev->pen)(dev, 1, CapButt, FillSolid);
+   }
+  else if (w->WorldType == GARDEN)
+    (*dev->fill_arc)(dev, INK, x_ctr-S(10), y_ctr-S(13)+PAD, S(20), S(20));
+  else {
+    (*dev->fill_arc)(dev, INK, x_ctr-S(8), y_ctr-S(11)+PAD, S(5), S(5));
+    (*dev->fill_arc)(dev, INK, x_ctr,   y_ctr-S(7)+PAD, S(5), S(5));
+    (*dev->fill_arc)(dev, INK, x_ctr-S(8), y_ctr-S(3)+PAD,   S(5), S(5));
+    (*dev->fill_arc)(dev, INK, x_ctr+S(2), y_ctr-S(1)+PAD, S(5), S(5));
+   }
+
+  if (w->GasGiant) {
+    (*dev->fill_arc)(dev, PAPER, x_ctr+S(26), y_ctr-S(30)+PAD, S(13), S(13));
+    (*dev->fill_arc)(dev, INK, x_ctr+S(28), y_ctr-S(28)+PAD, S(9), S(9));
+   }
+
+  switch(w->Base[0]) {
+    case 'A'  : (*dev->symbol)(dev, SYM_NAVAL1, x_ctr-S(35), y_ctr-S(20)+PAD);
+                (*dev->symbol)(dev, SYM_SCOUT1, x_ctr-S(35), y_ctr-S(4)+PAD);
+                break;
+    case 'B'  : (*dev->symbol)(dev, SYM_NAVAL1, x_ctr-S(35), y_ctr-S(20)+PAD);
+                (*dev->symbol)(dev, SYM_SCOUT2, x_ctr-S(35), y_ctr-S(4)+PAD);
+                break;
+    case 'C'  : (*dev->symbol)(dev, SYM_CORSAIR, x_ctr-S(35), y_ctr-S(4)+PAD);
+                break;
+    case 'D'  : (*dev->symbol)(dev, SYM_DEPOT, x_ctr-S(35), y_ctr-S(20)+PAD);
+                break;
+    case 'H'  : (*dev->symbol)(dev, SYM_CORSAIR, x_ctr-S(35), y_ctr-S(4)+PAD);
+    case 'F'  :
+    case 'G'  :
+    case 'J'  : (*dev->symbol)(dev, SYM_NAVAL2, x_ctr-S(35), y_ctr-S(20)+PAD);
+                break;
+    case 'M'  : (*dev->symbol)(dev, SYM_MILITARY, x_ctr-S(35), y_ctr-S(4)+PAD);
+                break;
+    case 'N'  : (*dev->symbol)(dev, SYM_NAVAL1, x_ctr-S(35), y_ctr-S(20)+PAD);
+                break;
+    case 'R'  : (*dev->symbol)(dev, SYM_ASLAN, x_ctr-S(35), y_ctr-S(20)+PAD);
+                break;
+    case 'S'  : (*dev->symbol)(dev, SYM_SCOUT1, x_ctr-S(35), y_ctr-S(20)+PAD);
+                break;
+    case 'T'  : (*dev->symbol)(dev, SYM_TLAUKHU, x_ctr-S(35), y_ctr-S(4)+PAD);
+                break;
+    case 'W'  : (*dev->symbol)(dev, SYM_SCOUT2, x_ctr-S(35), y_ctr-S(20)+PAD);
+                break;
+    case 'Z'  : (*dev->symbol)(dev, SYM_ZHODANE, x_ctr-S(35), y_ctr-S(20)+PAD);
+    default   : break;
+   }
+  (*dev->text)(dev, x_ctr+l->hex_x, y_ctr-S(36)+PAD, w->hex, 4);
+  (*dev->font)(dev, FONT_BOLD);
+  (*dev->text)(dev, x_ctr-S(4), y_ctr-S(18)+PAD, w->Starport, 1);
+  (*dev->font)(dev, FONT_NORMAL);
+}
+
+void draw_world_parts(dev, w, x_ctr, y_ctr, parts)
+Device *dev;
+World *w;
+int x_ctr, y_ctr, parts;
+{
+  Label *l = world_label(dev, w);
+
+  if (parts & WORLD_SYMBOL)
+    draw_world_symbol(dev, w, l, x_ctr, y_ctr);
+  if (parts & WORLD_ALLEGIANCE)
+    (*dev->text)(dev, x_ctr+l->alleg_x, y_ctr+S(18)+PAD, w->allegiance, 2);
+  if (parts & WORLD_TRADE)
+    (*dev->text)(dev, x_ctr+l->notes_x, y_ctr+S(18)+PAD, w->notes,
+                l->notes_len);
+  if ((parts & WORLD_SYMBOL) && l->name_len) {
+    if (l->name_font != FONT_NORMAL)
+      (*dev->font)(dev, l->name_font);
+    (*dev->text)(dev, x_ctr+l->name_x, y_ctr+S(36)+PAD, w->name, l->name_len);
+    if (l->name_font != FONT_NORMAL)
+      (*dev->font)(dev, FONT_NORMAL);
+   }
+  if (parts & WORLD_UWP) {
+    (*dev->font)(dev, FONT_SMALL);
+    (*dev->text)(dev, x_ctr+l->uwp_x, y_ctr+S(46)+PAD, w->uwp, l->uwp_len);
+    (*dev->font)(dev, FONT_NORMAL);
+   }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  grow                                                            *
+ *                                                                           *
+ * Purpose:  Make room in one of the growable arrays (sec_world, t_route,    *
+ *           bdr_seg, ...) for element number 'need'.  'max' is the current  *
+ *           capacity and is doubled as often as necessary.                  *
+ *                                                                           *
+ *****************************************************************************/
+
+char *grow(ptr, max, need, size)
+char *ptr;
+int *max, need, size;
+{
+  if (need < *max)
+    return (ptr);
+  if (*max == 0) *max = 64;
+  while (need >= *max)
+    *max *= 2;
+  if ((ptr = realloc(ptr, *max * size)) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", program_name);
+    exit(1); }
+  return (ptr);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: open_text, close_text                                           *
+ *                                                                           *
+ * Purpose:  Make the whole of a datafile addressable at once.  A regular    *
+ *           file is mmap'ed read-only, so nothing is copied; anything else  *
+ *           (a pipe, an empty file) is read into a malloc'ed buffer.        *
+ *                                                                           *
+ *****************************************************************************/
+
+int open_text(name, tf)
+char *name;
+TextFile *tf;
+{
+  struct stat st;
+  long n, max;
+  int fd;
+
+  tf->text = NULL;
+  tf->size = 0;
+  tf->mapped = FALSE;
+  if ((fd = open(name, O_RDONLY)) < 0)
+    return (FALSE);
+  if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0)) {
+    tf->text = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (tf->text != (char *) MAP_FAILED) {
+      tf->size = st.st_size;
+      tf->mapped = TRUE;
+      close(fd);
+      return (TRUE);
      }
-    len = XTextWidth(fptr, w->hex, 4); 
-    XDrawImageString(dpy, d, black_gc, x_ctr-(len/2), y_ctr-36+PAD, w->hex, 4);
-    XSetFont(dpy, black_gc, fBptr->fid);
-    XDrawImageString(dpy, d, black_gc, x_ctr-4, y_ctr-18+PAD, w->Starport, 1);
-    XSetFont(dpy, black_gc, fptr->fid);
-    if (DISP_ALL) {
-    	len = XTextWidth(fptr, w->allegiance, 2); 
-    	XDrawImageString(dpy, d, black_gc, x_ctr-30-(len/2), y_ctr+18+PAD,
-                w->allegiance, 2);
-    }
-    if (w->notes && DISP_TRADE) {
-    	len = XTextWidth(fptr, w->notes, strlen(w->notes)); 
-    	XDrawImageString(dpy, d, black_gc, x_ctr+25-(len/2), y_ctr+18+PAD,
-		w->notes, strlen(w->notes));
-    }
-    if (strlen(w->name)) {
-	if (w->uwp[3] >= '9') {
-		XSetFont(dpy, black_gc, fBptr->fid);
-    	        len = XTextWidth(fBptr, w->name, strlen(w->name)); 
-    	    	XDrawImageString(dpy, d, black_gc, x_ctr-(len/2), y_ctr+36+PAD, 
-				w->name, strlen(w->name));
-		XSetFont(dpy, black_gc, fptr->fid);
-	} else {
-    	        len = XTextWidth(fptr, w->name, strlen(w->name)); 
-    	    	XDrawImageString(dpy, d, black_gc, x_ctr-(len/2), y_ctr+36+PAD, 
-				w->name, strlen(w->name));
-	}
-    }
-    if (DISP_CODE) {
-    	XSetFont(dpy, black_gc, fsptr->fid);
-    	len = XTextWidth(fsptr, w->name, strlen(w->uwp)); 
-    	XDrawImageString(dpy, d, black_gc, x_ctr-(len/2), y_ctr+46+PAD, 
-				w->uwp, strlen(w->uwp));
-    	XSetFont(dpy, black_gc, fptr->fid);
-    }
+    tf->text = NULL;
    }
-  XFlush(dpy);
+  max = 0;
+  do {
+    tf->text = grow(tf->text, &max, tf->size + 4096, 1);
+    n = read(fd, tf->text + tf->size, max - tf->size);
+    if (n > 0)
+      tf->size += n;
+   } while (n > 0);
+  close(fd);
+  return (n == 0);
 }
 
-load_sector_file(argc, argv)
-int argc;
-char *argv[];
+void close_text(tf)
+TextFile *tf;
 {
-  int done, count, i, atmosphere, hydrology, x_off, y_off;
-  char str[10], ch, *status, t_start[5], t_end[5], offset[5];
-  World *w;
-  FILE *fd;
+  if (tf->mapped)
+    munmap(tf->text, (size_t) tf->size);
+  else
+    free(tf->text);
+  tf->text = NULL;
+}
 
-  fd = fopen(argv[arg_cnt], "r");
-  if (fd == NULL) {
-      fprintf(stderr, "%s: Cannot open %s for input\n", argv[0], argv[arg_cnt]);
-      exit(1); }
+/*-- hand each line of 'size' bytes of text to parse_sector_line(), the
+     text being a file of its own as far as tab headers go --*/
+static void parse_sector_text(text, size, sx, sy)
+char *text;
+long size;
+int sx, sy;
+{
+  char *p, *nl, *end;
+
+  tab_reset();
+  end = text + size;
+  for (p=text; p<end; p=nl+1) {
+    if ((nl = memchr(p, '\n', end - p)) == NULL)
+      nl = end;
+    parse_sector_line(p, nl - p, sx, sy);
+    stats_lines++;
+   }
+}
 
-  done = FALSE;
+/*****************************************************************************
+ *                                                                           *
+ * Routines: load_sector_file, load_sector_text                              *
+ *                                                                           *
+ * Purpose:  Replace whatever is loaded with the datafile 'name', or with    *
+ *           the 'size' bytes of datafile text at 'text' (serve.c gets these *
+ *           over its socket).  load_sector_file() returns FALSE if the file *
+ *           cannot be read.                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+static void load_clear()
+{
   w_cnt = 0;
   tr_cnt = 0;
   bdr_cnt = 0;
   private_bdr_cnt = 0;
-  while ((w_cnt < 80) && (tr_cnt < 80) && !done) {
-    status = fgets(line, 81, fd);
-    if (status == NULL) done++;
-    if (line[0] == '#')
-      continue;
-    if (line[0] == '@') {
-      strcpy(title, &line[1]);
-      continue;
-     }
-    if (line[0] == '^') {
-      load_bdr_seg(line);
-      continue;
-     }
-    if (line[0] == '$') {
+}
+
+int load_sector_file(name)
+char *name;
+{
+  load_clear();
+  if (!read_sector_file(name, 0, 0))
+    return (FALSE);
+  if (claim_radius >= 0)
+    border_claims(NULL, claim_radius);
+  return (TRUE);
+}
+
+void load_sector_text(text, size)
+char *text;
+long size;
+{
+  double start;
+
+  start = stats_clock();
+  load_clear();
+  hex_index_stale();
+  label_stale();
+  parse_sector_text(text, size, 0, 0);
+  stats_time(STAT_PARSE, start);
+  if (claim_radius >= 0)
+    border_claims(NULL, claim_radius);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  read_sector_file                                                *
+ *                                                                           *
+ * Purpose:  Append the worlds, routes and borders in a datafile to those    *
+ *           already loaded.  Everything is kept twice: folded into the one  *
+ *           subsector gen_sector() draws, and as absolute hexes (col, row   *
+ *           from 0) for the sector at [sx, sy] in a grid of sectors, which  *
+ *           is what gen_map() draws.  A route whose destination offset      *
+ *           points off the sector while its hex number wraps back into it   *
+ *           is taken to end in the neighbouring sector.  The file is parsed *
+ *           where it lies, in one pass, however long its lines, and what    *
+ *           is made of it is kept in its cache file; if that is up to date  *
+ *           it is loaded from there instead (cache.c).                      *
+ *                                                                           *
+ *****************************************************************************/
+
+int read_sector_file(name, sx, sy)
+char *name;
+int sx, sy;
+{
+  TextFile tf;
+  double start;
+
+  start = stats_clock();
+  hex_index_stale();
+  label_stale();
+  if (cache_load(name, sx, sy)) {
+    stats_time(STAT_PARSE, start);
+    return (TRUE);
+   }
+  cache_begin(name);
+  if (!open_text(name, &tf)) {
+      fprintf(stderr, "%s: Cannot open %s for input\n", program_name, name);
+      return (FALSE); }
+
+  parse_sector_text(tf.text, tf.size, sx, sy);
+  cache_save(name, tf.text, tf.size, sx, sy);
+  close_text(&tf);
+  stats_time(STAT_PARSE, start);
+  return (TRUE);
+}
+
+/*****************************************************************************
+ **
+ **  The fixed columns of a line are read straight out of the text.  COL()
+ **  is the character in a column, a blank past the end of a short line;
+ **  col_int() is what atoi() would make of 'width' columns.
+ **
+ *****************************************************************************/
+
+#define COL(i)  (((i) < len) ? text[i] : ' ')
+
+static int col_int(text, len, i, width)
+char *text;
+int len, i, width;
+{
+  int v = 0, neg = FALSE, end = i + width;
+
+  while ((i < end) && (COL(i) == ' '))
+    i++;
+  if ((i < end) && ((COL(i) == '-') || (COL(i) == '+'))) {
+    neg = (COL(i) == '-');
+    i++;
+   }
+  for (; (i < end) && (COL(i) >= '0') && (COL(i) <= '9'); i++)
+    v = v * 10 + (COL(i) - '0');
+  return (neg ? -v : v);
+}
+
+/*-- copy 'width' columns starting at 'i' into a string --*/
+static void col_str(text, len, i, width, str)
+char *text, *str;
+int len, i, width;
+{
+  int k;
+
+  for (k=0; k<width; k++)
+    str[k] = COL(i + k);
+  str[width] = '\0';
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  world_finish                                                    *
+ *                                                                           *
+ * Purpose:  Complete the World 'w' at the end of sec_world, whose hex and   *
+ *           uwp have been filled in by parse_sector_line() or tab_world():  *
+ *           place it in the sector at [sx, sy], work out its WorldType and  *
+ *           count it.                                                       *
+ *                                                                           *
+ *****************************************************************************/
+
+void world_finish(w, sx, sy)
+World *w;
+int sx, sy;
+{
+  int col, row;
+
+/*--- convert hex string to digits ---*/
+  col = (w->hex[0] - '0') * 10 + (w->hex[1] - '0');
+  row = (w->hex[2] - '0') * 10 + (w->hex[3] - '0');
+  w->location.x = (col - 1) % 8;
+  w->location.y = (row - 1) % 10;
+  w->col = sx * SECTOR_COLS + col - 1;
+  w->row = sy * SECTOR_ROWS + row - 1;
+
+/*--- get WorldType: no water is DESERT, size 0 is ASTEROID ---*/
+/********************************************
+  if ((atmosphere < 4) || (hydrology == 0))
+*********************************************/
+  if (w->uwp[2] == '0')
+    w->WorldType = DESERT;
+  else
+    w->WorldType = GARDEN;
+  if (w->uwp[0] == '0')
+    w->WorldType = ASTEROID;
+  w_cnt++;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  parse_sector_line                                               *
+ *                                                                           *
+ * Purpose:  Decode one line of a datafile (a title, route, border or world) *
+ *           for the sector at [sx, sy].  The 'len' bytes at 'text' are the  *
+ *           line without its newline, and need not be NUL terminated.       *
+ *           Worlds are in the GEnie fixed columns, or in tab delimited      *
+ *           (T5 SEC) columns named by a header line, which tab.c reads.     *
+ *                                                                           *
+ *****************************************************************************/
+
+void parse_sector_line(text, len, sx, sy)
+char *text;
+int len, sx, sy;
+{
+  int i, k, col, row, x_off, y_off;
+  World *w;
+  Route *rt;
+
+  while ((len > 0) && ((text[len-1] == '\n') || (text[len-1] == '\r')))
+    len--;
+  if ((len == 0) || (text[0] == '#'))
+    return;
+  if (text[0] == '@') {
+/*--- gen_sector() expects the title to end in a newline, as fgets left it ---*/
+    k = (len - 1 < 78) ? len - 1 : 78;
+    memcpy(title, &text[1], k);
+    title[k] = '\n';
+    title[k+1] = '\0';
+    titles_read++;
+    return;
+   }
+  if (text[0] == '^') {
+    load_bdr_seg(text, len, sx, sy);
+    return;
+   }
+  if (text[0] == '$') {
 /*--- get trade route segment ---*/
-      strncpy(t_start, &line[1], 4);
-      strncpy(t_end, &line[6], 4);
-      strncpy(offset, &line[11], 4);
-      t_start[4] = NULL;
-      t_end[4] = NULL;
-      offset[4] = NULL;
-      strncpy(str, t_start, 2);
-      str[2] = NULL;
-      t_route[tr_cnt].x1 = (atoi(str) - 1) % 8;
-      strncpy(str, &(t_start[2]), 2);
-      str[2] = NULL;
-      t_route[tr_cnt].y1 = (atoi(str) - 1) % 10;
-      strncpy(str, t_end, 2);
-      str[2] = NULL;
-      t_route[tr_cnt].x2 = (atoi(str) - 1) % 8;
-      strncpy(str, &(t_end[2]), 2);
-      str[2] = NULL;
-      t_route[tr_cnt].y2 = (atoi(str) - 1) % 10;
-
-      strncpy(str, offset, 2);
-      str[2] = NULL;
-      x_off = atoi(str);
-      if (x_off) {
-        if (x_off < 0)
-          t_route[tr_cnt].x2 -= 8;
-        else
-          t_route[tr_cnt].x2 += 8;
+    t_route = (Route *) grow((char *) t_route, &tr_max, tr_cnt, sizeof(Route));
+    rt = &t_route[tr_cnt];
+    col = col_int(text, len, 1, 2);
+    row = col_int(text, len, 3, 2);
+    rt->c1 = sx * SECTOR_COLS + col - 1;
+    rt->r1 = sy * SECTOR_ROWS + row - 1;
+    rt->x1 = (col - 1) % 8;
+    rt->y1 = (row - 1) % 10;
+    col = col_int(text, len, 6, 2);
+    row = col_int(text, len, 8, 2);
+    rt->c2 = sx * SECTOR_COLS + col - 1;
+    rt->r2 = sy * SECTOR_ROWS + row - 1;
+    rt->x2 = (col - 1) % 8;
+    rt->y2 = (row - 1) % 10;
+
+    x_off = col_int(text, len, 11, 2);
+    if (x_off) {
+      if (x_off < 0) {
+        rt->x2 -= 8;
+        if (rt->c2 > rt->c1) rt->c2 -= SECTOR_COLS;
+       }
+      else {
+        rt->x2 += 8;
+        if (rt->c2 < rt->c1) rt->c2 += SECTOR_COLS;
+       }
+     }
+    y_off = col_int(text, len, 13, 2);
+    if (y_off) {
+      if (y_off < 0) {
+        rt->y2 -= 10;
+        if (rt->r2 > rt->r1) rt->r2 -= SECTOR_ROWS;
        }
-      strncpy(str, &(offset[2]), 2);
-      str[2] = NULL;
-      y_off = atoi(str);
-      if (y_off) {
-        if (y_off < 0)
-          t_route[tr_cnt].y2 -= 10;
-        else
-          t_route[tr_cnt].y2 += 10;
+      else {
+        rt->y2 += 10;
+        if (rt->r2 < rt->r1) rt->r2 += SECTOR_ROWS;
        }
-      tr_cnt++;
-      continue;
      }
+    tr_cnt++;
+    return;
+   }
 
-    w = &sec_world[w_cnt];
-/*--- get the world name ---*/
-    i = 12;
-    while ((line[i--] == ' ') && (i >= 0));
-    if (i <= 0)
-      w->name[0] = NULL;
-    else
-      strncpy(w->name, line, i+2);
-      w->name[i+2] = NULL;
+  if ((memchr(text, '\t', len) != NULL) &&
+      (tab_world(text, len, sx, sy) || tab_header(text, len)))
+    return;
+
+/*--- anything without a hex number in columns 14-17 is not a world ---*/
+  for (i=14; i<18; i++)
+    if ((COL(i) < '0') || (COL(i) > '9')) return;
+
+  sec_world = (World *) grow((char *) sec_world, &w_max, w_cnt, sizeof(World));
+  w = &sec_world[w_cnt];
+/*--- get the world name: columns 0-12, trailing blanks dropped ---*/
+  for (i=12; (i >= 0) && (COL(i) == ' '); i--);
+  col_str(text, len, 0, i+1, w->name);
 
 /*--- get world hex location string ---*/
-    strncpy(w->hex, &line[14], 4);
-    w->hex[4] = NULL;
+  col_str(text, len, 14, 4, w->hex);
 
 /*--- get world Starport type ---*/
-    w->Starport[0] = line[19];
-    w->Starport[1] = NULL;
+  col_str(text, len, 19, 1, w->Starport);
 
 /*--- get uwp ---*/
-    w->uwp[0] = line[20];
-    w->uwp[1] = line[21];
-    w->uwp[2] = line[22];
-    w->uwp[3] = line[23];
-    w->uwp[4] = line[24];
-    w->uwp[5] = line[25];
-    w->uwp[6] = line[26];
-    w->uwp[7] = line[27];
-    w->uwp[8] = NULL;
+  col_str(text, len, 20, 8, w->uwp);
 
 /*--- get world base (Naval, Scout, etc.) type ---*/
-    w->Base[0] = line[30];
-    w->Base[1] = NULL;
+  col_str(text, len, 30, 1, w->Base);
 
-/*--- get world notes ---*/
-    if ((w->notes[0] = line[32]) == ' ') w->notes[0] = NULL;
-    else {
-    	w->notes[1] = line[33];
-    	if ((w->notes[2] = line[35]) == ' ') w->notes[2] = NULL;
-    	else {
-            w->notes[3] = line[36];
-            if ((w->notes[4] = line[38]) == ' ') w->notes[4] = NULL;
-	    else {
-    	    	w->notes[5] = line[39];
-    	    	if ((w->notes[6] = line[41]) == ' ') w->notes[6] = NULL;
-	    	else {
-    		    w->notes[7] = line[42];
-    		    if ((w->notes[8] = line[44]) == ' ') w->notes[8] = NULL;
-		    else {
-    		    	w->notes[9] = line[45];
-    		    	w->notes[10] = NULL;
-		    }
-	        }
-	    }
-        }
-    }
+/*--- get world notes: up to 5 two letter codes, run together ---*/
+  for (i=32, k=0; (i <= 44) && (COL(i) != ' '); i+=3) {
+    w->notes[k++] = COL(i);
+    w->notes[k++] = COL(i+1);
+   }
+  w->notes[k] = '\0';
 
 /*--- get world zone type ---*/
-    w->Zone[0] = line[48];
-    w->Zone[1] = NULL;
+  col_str(text, len, 48, 1, w->Zone);
 
 /*--- get world allegiance ---*/
-    strncpy(w->allegiance, &line[55], 2);
-    w->allegiance[2] = NULL;
+  col_str(text, len, 55, 2, w->allegiance);
 
-/*--- get no. of Gas Giants ---*/
-    strncpy(str, &line[53], 1);
-    str[1] = NULL;
-    w->GasGiant = atoi(str);
+/*--- get no. of Gas Giants, and the whole population/belts/giants code ---*/
+  w->GasGiant = col_int(text, len, 53, 1);
+  col_str(text, len, 51, 3, w->pbg);
 
-/*--- convert hex string to digits ---*/
-    strncpy(str, w->hex, 2);
-    str[2] = NULL;
-    w->location.x = (atoi(str) - 1) % 8;
-    strncpy(str, &(w->hex[2]), 2);
-    str[2] = NULL;
-    sec_world[w_cnt].location.y = (atoi(str) - 1) % 10;
-
-/*--- get WorldType (GARDEN/DESERT) ---*/
-    str[0] = line[21];
-    str[1] = NULL;
-    switch (str[0]) {
-        case '0' :
-        case '1' :
-        case '2' :
-        case '3' : atmosphere = 0;
-                   break;
-        default  : atmosphere = 10;
-                   break;
-     }
-    str[0] = line[22];
-    str[1] = NULL;
-    switch (str[0]) {
-        case '0' : hydrology = 0;
-                   break;
-        default  : hydrology = 10;
-     }
-/********************************************
-    if ((atmosphere < 4) || (hydrology == 0))
-*********************************************/
-    if (hydrology == 0)
-      w->WorldType = DESERT;
-    else
-      w->WorldType = GARDEN;
-    if (line[20] == '0')
-      w->WorldType = ASTEROID;
-    w_cnt++;
-   }
-  w_cnt--;
-  fclose(fd);
-  return (TRUE);
+  world_finish(w, sx, sy);
 }
 
 /*****************************************************************************
@@ -855,9 +1104,9 @@ char *argv[];
  * Routine:  load_bdr_seg                                                    *
  *                                                                           *
  * Purpose:  This routine reads a static border element from the datafile    *
- *           and converts it into an Xsegment containing absolute values     *
- *           for those endpoints.  Each segment listed in the datefile has   *
- *           the following format (starting in column 0):                    *
+ *           and hands it to border_add(), which keeps each edge once and    *
+ *           works out its endpoints.  Each segment listed in the datefile   *
+ *           has the following format (starting in column 0):                *
  *                                                                           *
  *                 ^nnnn m                                                   *
  *                                                                           *
@@ -868,36 +1117,21 @@ char *argv[];
  *                                                                           *
  *****************************************************************************/
 
-load_bdr_seg(str)
-char *str;
+void load_bdr_seg(text, len, sx, sy)
+char *text;
+int len, sx, sy;
 {
-  int i, lx, ly, x_off, y_off, edge, next_edge;
-  char bdr_hex[3], edge_char[2];
+  int col, row, edge;
 
 /*--- convert hex location strings & edge strings to digits ---*/
-  bdr_hex[0] = str[1];
-  bdr_hex[1] = str[2];
-  bdr_hex[2] = NULL;
-  lx = (atoi(bdr_hex) - 1) % 8;
-  bdr_hex[0] = str[3];
-  bdr_hex[1] = str[4];
-  bdr_hex[2] = NULL;
-  ly = (atoi(bdr_hex) - 1) % 10;
-  edge_char[0] = str[6];
-  edge_char[1] = NULL;
-  edge = atoi(edge_char);
-  next_edge = (edge + 1) % 6;
-  i = private_bdr_cnt;
-  x_off = hex_loc[lx].x;
-  y_off = hex_loc[lx].y + (ly * LINE_INC) + PAD;
-  file_bdr_seg[i].x1 = abs_hex_pts[edge].x + x_off;
-  file_bdr_seg[i].y1 = abs_hex_pts[edge].y + y_off;
-  file_bdr_seg[i].x2 = abs_hex_pts[next_edge].x + x_off;
-  file_bdr_seg[i].y2 = abs_hex_pts[next_edge].y + y_off;
-  private_bdr_cnt++;
+  col = col_int(text, len, 1, 2);
+  row = col_int(text, len, 3, 2);
+  edge = col_int(text, len, 6, 1) % 6;
+  cache_border(col - 1, row - 1, edge);
+  border_add(sx * SECTOR_COLS + col - 1, sy * SECTOR_ROWS + row - 1, edge);
 }
 
-print_sector_file()
+void print_sector_file()
 {
   int i;
 
@@ -930,11 +1164,12 @@ print_sector_file()
 }
 
 
-repaint_buttons()
+void repaint_buttons()
 {
   int i, len, y_pos;
   GC  tgc;
 
+  XSetFont(dpy, black_gc, fptr->fid);
   y_pos = (BTN_HEIGHT - fptr->ascent - fptr->descent) / 2 + fptr->ascent;
 
   for (i=0; i<NUM_BTNS; i++) {
@@ -952,10 +1187,77 @@ repaint_buttons()
 			button_label[i], strlen(button_label[i]));
    } /* for */
   XFlush(dpy);
+  stats_flushes++;
 }
 
 
-mark_border()
+/*****************************************************************************
+ *                                                                           *
+ * Routines: inspect, repaint_info                                           *
+ *                                                                           *
+ * Purpose:  inspect() puts the world under pixel [x, y] of the map window   *
+ *           in the INSPECTOR window, when the pointer moves onto another    *
+ *           hex or is clicked; repaint_info() draws it.  The hex is found   *
+ *           by pixel_to_hex() and its world by world_at(), neither of which *
+ *           looks through the worlds loaded.  The window shows the worlds   *
+ *           folded into one subsector (loaded_subsector()).                 *
+ *                                                                           *
+ *****************************************************************************/
+
+static int info_col = -1, info_row = -1;
+
+static void inspect(x, y)
+int x, y;
+{
+  View v;
+  int c, r;
+
+  if (!loaded_subsector(&v))
+    return;
+  if (!pixel_to_hex(&v, x, y, &c, &r))
+    c = r = -1;
+  if ((c == info_col) && (r == info_row))
+    return;
+  info_col = c;
+  info_row = r;
+  repaint_info();
+}
+
+void repaint_info()
+{
+  char lines[NUM_INFO][INFO_WIDTH];
+  int i, k, n, line_h;
+
+  XClearWindow(dpy, info);
+  XSetFont(dpy, black_gc, fptr->fid);
+  line_h = fptr->ascent + fptr->descent;
+  n = 0;
+  if ((info_col >= 0) && ((k = world_at(info_col, info_row)) >= 0))
+    n = world_info(&sec_world[k], lines);
+  else if (info_col >= 0) {
+    sprintf(lines[0], "%02d%02d  (no world)", info_col % SECTOR_COLS + 1,
+                info_row % SECTOR_ROWS + 1);
+    n = 1;
+   }
+  for (i=0; i<n; i++)
+    XDrawImageString(dpy, info, black_gc, 5, 5 + fptr->ascent + i * line_h,
+                lines[i], strlen(lines[i]));
+  XFlush(dpy);
+  stats_flushes++;
+}
+
+/*-- a window coordinate on the 10 pixel grid borders are marked on, taken
+     at scale 1 so that the points stay on the hex edges at any scale --*/
+static int snap(v)
+int v;
+{
+  v = (int) (v / geom->scale);
+  if (v < 0) v = 0;
+  if (v > MAX_PX - 20) v = MAX_PX - 20;
+  return (S(((v+5) / 10) * 10));
+}
+
+void mark_border()
 {
   int pressed, x, y, old_x, old_y, done, first;
 
@@ -963,7 +1265,7 @@ mark_border()
   repaint_buttons();
 
   cur_bdr_cnt = bdr_cnt;
-  XSetLineAttributes(dpy, black_gc, 5, LineSolid, CapButt, JoinMiter);
+  XSetLineAttributes(dpy, black_gc, S(5), LineSolid, CapButt, JoinMiter);
   XSetFillStyle(dpy, black_gc, FillTiled);
   pressed = FALSE;
   done = FALSE;
@@ -974,8 +1276,8 @@ mark_border()
       case ButtonPress    : if (!pressed) {
                               if (event.xbutton.window == win) {
                                 pressed = TRUE;
-                                x = ((event.xbutton.x+5) / 10) * 10;
-                                y = ((event.xbutton.y+5) / 10) * 10 - 4;
+                                x = snap(event.xbutton.x);
+                                y = snap(event.xbutton.y) - S(4);
                                 old_x = x;
                                 old_y = y;
                                }
@@ -984,6 +1286,9 @@ mark_border()
                             if (event.xbutton.window == win) {
                                 XDrawLine(dpy, win, black_gc,
                                         old_x, old_y, x, y);
+                                bdr_seg = (XSegment *) grow((char *)
+                                        bdr_seg, &seg_max, bdr_cnt,
+                                        sizeof(XSegment));
                                 bdr_seg[bdr_cnt].x1 = old_x;
                                 bdr_seg[bdr_cnt].y1 = old_y;
                                 bdr_seg[bdr_cnt].x2 = x;
@@ -991,8 +1296,8 @@ mark_border()
                                 bdr_cnt++;
                                 if (event.xbutton.button == Button3)
                                   done = TRUE;
-                                x = ((event.xbutton.x+5) / 10) * 10;
-                                y = ((event.xbutton.y+5) / 10) * 10 - 4;
+                                x = snap(event.xbutton.x);
+                                y = snap(event.xbutton.y) - S(4);
                                 old_x = x;
                                 old_y = y;
                                }
@@ -1004,34 +1309,38 @@ mark_border()
                                   XDrawLine(dpy, win, flicker_gc,
                                                 old_x, old_y, x, y);
                                  }
-                                x = ((event.xbutton.x+5) / 10) * 10;
-                                y = ((event.xbutton.y+5) / 10) * 10 - 4;
+                                x = snap(event.xbutton.x);
+                                y = snap(event.xbutton.y) - S(4);
                                 XDrawLine(dpy, win, flicker_gc,
                                                 old_x, old_y, x, y);
                                 first = FALSE;
                                }
                              }
                             XFlush(dpy);
+                            stats_flushes++;
                             break;
      }
    }
   XSetLineAttributes(dpy, black_gc, 1, LineSolid, CapButt, JoinMiter);
   XSetFillStyle(dpy, black_gc, FillSolid);
+  layer_invalidate(LAYER_BORDERS);
   button_state[0] = FALSE;
   repaint_buttons();
 }
 
 
-print_subsector()
+int print_subsector()
 {
   unsigned long swaptest = TRUE;
-  XColor *colors;
+  IMGColor *colors;
   Pixmap PrintPix;
   unsigned buffer_size;
   int win_name_size;
   int header_size;
-  int ncolors, i;
-  char *win_name;
+  int ncolors, i, status;
+  char *win_name, print_name[8];
+  double start;
+  Device *dev;
   XImage *ImagePix;
   XWindowAttributes win_info;
   FILE *out;
@@ -1041,39 +1350,81 @@ print_subsector()
   button_state[2] = TRUE;
   repaint_buttons();
 
+/*-- SVG and PostScript are drawn from the map data, not read back --*/
+  if ((out_format == FORMAT_SVG) || (out_format == FORMAT_PS)) {
+    sprintf(print_name, "ssv%s", raster_extension());
+    status = raster_print_subsector(print_name);
+    button_state[2] = FALSE;
+    repaint_buttons();
+    return (status);
+   }
+
 /*-- Get the parameters of the window being dumped --*/
   if(!XGetWindowAttributes(dpy, win, &win_info))
     return(FALSE);
 
-  PrintPix = XCreatePixmap(dpy, win, 770, 1070+PAD, ScrDepth);
-  if (PrintPix == NULL)
+  PrintPix = XCreatePixmap(dpy, win, MAP_WIDTH, MAP_HEIGHT, ScrDepth);
+  if (PrintPix == None)
     return (FALSE);
 
-  XFillRectangle(dpy, PrintPix, white_gc, 0, 0, 770, 1070+PAD);
+  layer_show(PrintPix, display_parts());
 
-  gen_sector(PrintPix);
-
-  out = fopen("ssv.xwd", "w");
-  win_name = "ssv.xwd";
+  sprintf(print_name, "ssv%s", raster_extension());
+  win_name = print_name;
 
 /*-- sizeof(char) is included for the null string terminator. --*/
   win_name_size = strlen(win_name) + sizeof(char);
 
 /*-- Snarf the pixmap with XGetImage --*/
-  ImagePix = XGetImage(dpy, PrintPix, 0, 0, 770, 1080, AllPlanes, ZPixmap); 
+  start = stats_clock();
+  ImagePix = XGetImage(dpy, PrintPix, 0, 0, MAP_WIDTH, PRINT_HEIGHT, AllPlanes,
+                ZPixmap);
   XSync(dpy, FALSE);
+  stats_flushes++;
+  stats_time(STAT_GET_IMAGE, start);
 
   if (ImagePix == NULL)
     return(FALSE);
 
+/*-- A 1 bit format is packed from a PAPER/INK copy by raster_write --*/
+  if (out_format != FORMAT_XWD) {
+    dev = raster_from_image(ImagePix, WhitePixel(dpy, DefaultScreen(dpy)));
+    status = (dev != NULL) && raster_write(dev, win_name, ImagePix->height);
+    if (dev != NULL)
+      raster_free(dev);
+    XDestroyImage(ImagePix);
+    XFreePixmap(dpy, PrintPix);
+    button_state[2] = FALSE;
+    repaint_buttons();
+    return (status);
+   }
+
+  if ((out = fopen(win_name, "w")) == NULL) {
+    fprintf(stderr, "%s: Cannot open %s for output\n", program_name, win_name);
+    XDestroyImage(ImagePix);
+    XFreePixmap(dpy, PrintPix);
+    button_state[2] = FALSE;
+    repaint_buttons();
+    return (FALSE);
+   }
+
 /*-- Determine the pixmap size --*/
   buffer_size = ImagePix->bytes_per_line * ImagePix->height;
 
 /*-- Get the RGB values for the current color cells --*/
-  if ((ncolors = Get_Colors(&colors)) == 0)
+  start = stats_clock();
+  if ((ncolors = Get_Colors(&colors)) == 0) {
+    fclose(out);
+    XDestroyImage(ImagePix);
+    XFreePixmap(dpy, PrintPix);
+    button_state[2] = FALSE;
+    repaint_buttons();
     return(FALSE);
+   }
 
   XFlush(dpy);
+  stats_flushes++;
+  stats_time(STAT_GET_COLORS, start);
 
 /*-- Calculate header size --*/
   header_size = sizeof(header) + win_name_size;
@@ -1109,17 +1460,18 @@ print_subsector()
   if (*(char *) &swaptest) {
     _swaplong((char *) &header, sizeof(header));
     for (i = 0; i < ncolors; i++) {
-        _swaplong((char *) &colors[i].pixel, sizeof(long));
+        _swaplong((char *) &colors[i].pixel, sizeof(imgval));
         _swapshort((char *) &colors[i].red, 3 * sizeof(short));
     }
   }
 
 /*-- Write out the file header information --*/
+  start = stats_clock();
   (void) fwrite((char *)&header, sizeof(header), 1, out);
   (void) fwrite(win_name, win_name_size, 1, out);
 
 /*-- Write out the color cell RGB values --*/
-  (void) fwrite((char *) colors, sizeof(XColor), ncolors, out);
+  (void) fwrite((char *) colors, sizeof(IMGColor), ncolors, out);
 
 /*-- Write out the buffer --*/
   (void) fwrite(ImagePix->data, (int) buffer_size, 1, out);
@@ -1132,6 +1484,8 @@ print_subsector()
   XFreePixmap(dpy, PrintPix);
 
   fclose(out);
+  stats_bytes += header_size + ncolors * sizeof(IMGColor) + buffer_size;
+  stats_time(STAT_WRITE, start);
   button_state[2] = FALSE;
   repaint_buttons();
 
@@ -1143,31 +1497,46 @@ print_subsector()
  *                                                                         *
  * Routine:   Get_Colors                                                   *
  *                                                                         *
- * Purpose:   Given a ptr. to an XColor struct., return the total number   *
+ * Purpose:   Given a ptr. to an IMGColor ptr., return the total number    *
  *            of cells in the current colormap, plus all of their RGB      *
- *            values.                                                      *
+ *            values, as the 12 byte XWDColor records of an xwd file.      *
  *                                                                         *
  *X11***********************************************************************/
 
-Get_Colors(colors)
-XColor **colors;
+int Get_Colors(colors)
+IMGColor **colors;
 {
   int i, ncolors;
+  XColor *cells;
 
   ncolors = DisplayCells(dpy, DefaultScreen(dpy));
 
-  if ((*colors = (XColor *) malloc (sizeof(XColor) * ncolors)) == NULL)
+  if ((cells = (XColor *) malloc (sizeof(XColor) * ncolors)) == NULL)
+    return(FALSE);
+  if ((*colors = (IMGColor *) malloc (sizeof(IMGColor) * ncolors)) == NULL) {
+    free(cells);
     return(FALSE);
+   }
 
   for (i=0; i<ncolors; i++)
-      (*colors)[i].pixel = i;
+      cells[i].pixel = i;
 
   XQueryColors(dpy, XDefaultColormap(dpy, XDefaultScreen(dpy)),
-                *colors, ncolors);
+                cells, ncolors);
+
+  for (i=0; i<ncolors; i++) {
+      (*colors)[i].pixel = (imgval) cells[i].pixel;
+      (*colors)[i].red = cells[i].red;
+      (*colors)[i].green = cells[i].green;
+      (*colors)[i].blue = cells[i].blue;
+      (*colors)[i].flags = cells[i].flags;
+      (*colors)[i].pad = 0;
+  }
+  free(cells);
   return(ncolors);
 }
 
-_swapshort (bp, n)
+void _swapshort (bp, n)
 register char *bp;
 register unsigned n;
 {
@@ -1184,7 +1553,7 @@ register unsigned n;
   }
 }
 
-_swaplong (bp, n)
+void _swaplong (bp, n)
 register char *bp;
 register unsigned n;
 {
@@ -1207,8 +1576,18 @@ register unsigned n;
   }
 }
 
-usage()
+void usage()
 {
-  fprintf(stderr, "Usage: %s [-p] datafile \n", program_name);
+  fprintf(stderr, "Usage: %s [-p] [-r] [--stats[=file]] [--no-cache] [--watch] [-a radius] [-z scale] [-f format] [-o output] datafile \n",
+                program_name);
+  fprintf(stderr, "       %s -b [-a radius] [-z scale] [-f format] [-j jobs] [datafile ...]\n", program_name);
+  fprintf(stderr, "       %s -b -x [-w] [-a radius] [-z scale] [-f format] [-j jobs] sector_datafile\n", program_name);
+  fprintf(stderr, "       %s -s [-v col,row,cols,rows] [-a radius] [-z scale] [-f format] [-j threads] [-o output] datafile[@sx,sy] ...\n",
+        program_name);
+  fprintf(stderr, "       %s -t jump [-P col,row,col,row] ... datafile[@sx,sy] ...\n",
+        program_name);
+  fprintf(stderr, "       %s [-r] --serve=socket\n", program_name);
+  fprintf(stderr, "       (format is xwd, bitmap, pbm, svg or ps; scale is %g to %g)\n",
+        MIN_SCALE, MAX_SCALE);
   exit(1);
 }
@@ -0,0 +1,381 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Declarations shared by the ssv source modules.
+ **
+ **  File:              ssv.h
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xos.h>
+
+/*****************************************************************************
+ **
+ **  This next typedef is lifted straight out of the xwd/xwud utility pair,
+ **  and defines the file format used by them and the xpr print utility.
+ **  Every field is a 32 bit CARD32 in the file, whatever size a long is.
+ **
+ *****************************************************************************/
+
+typedef unsigned int imgval;
+
+#define XWD_FILE_VERSION    7
+
+typedef struct _img_file_header {
+        imgval header_size;       /* Size of the entire file header (bytes). */
+        imgval file_version;      /* FILE_VERSION */
+        imgval pixmap_format;     /* Pixmap format */
+        imgval pixmap_depth;      /* Pixmap depth */
+        imgval pixmap_width;      /* Pixmap width */
+        imgval pixmap_height;     /* Pixmap height */
+        imgval xoffset;           /* Bitmap x offset */
+        imgval byte_order;        /* MSBFirst, LSBFirst */
+        imgval bitmap_unit;       /* Bitmap unit */
+        imgval bitmap_bit_order;  /* MSBFirst, LSBFirst */
+        imgval bitmap_pad;        /* Bitmap scanline pad */
+        imgval bits_per_pixel;    /* Bits per pixel */
+        imgval bytes_per_line;    /* Bytes per scanline */
+        imgval visual_class;      /* Class of colormap */
+        imgval red_mask;          /* Z red mask */
+        imgval green_mask;        /* Z green mask */
+        imgval blue_mask;         /* Z blue mask */
+        imgval bits_per_rgb;      /* Log base 2 of distinct color values */
+        imgval colormap_entries;  /* Number of entries in colormap */
+        imgval ncolors;           /* Number of Color structures */
+        imgval window_width;      /* Window width */
+        imgval window_height;     /* Window height */
+        int window_x;             /* Window upper left X coordinate */
+        int window_y;             /* Window upper left Y coordinate */
+        imgval window_bdrwidth;   /* Window border width */
+} IMGFileHeader;
+
+/*-- one colormap cell as stored in an xwd file (XWDColor) --*/
+typedef struct _img_color {
+        imgval pixel;
+        unsigned short red, green, blue;
+        char flags, pad;
+} IMGColor;
+
+#define  TRUE   1
+#define  FALSE  0
+
+#define  GARDEN   2
+#define  ASTEROID 1
+#define  DESERT   0
+
+typedef struct _worldstruct {
+        XPoint location;
+        short col, row;           /* absolute hex, from 0 (see gen_map) */
+        int WorldType;
+        int GasGiant;
+        char Starport[2];
+        char Base[2];
+        char Zone[2];
+        char hex[5];
+        char name[21];
+	char uwp[9];
+	char notes[13];
+        char allegiance[3];
+        char pbg[4];
+        } World;
+
+/*-- a trade route: subsector hexes (gen_sector) and absolute hexes --*/
+typedef struct _route {
+        short x1, y1, x2, y2;
+        short c1, r1, c2, r2;
+        } Route;
+
+/*-- a border edge read from the datafile ('^hhhh e'), in absolute hexes --*/
+typedef struct _border {
+        short col, row, edge;
+        } Border;
+
+/*-- a chain of file borders: npoints points from file_bdr_pts[first] --*/
+typedef struct _bdrline {
+        int first, npoints;
+        } BdrLine;
+
+/*-- where the labels of a world go, from the center of its hex, and the
+     lengths and name font to draw them with (see label.c) --*/
+typedef struct _label {
+        short hex_x, alleg_x, notes_x, name_x, uwp_x;
+        char notes_len, name_len, uwp_len, name_font;
+        } Label;
+
+/*-- a datafile held in memory, mmap'ed if it could be (see open_text) --*/
+typedef struct _textfile {
+        char *text;
+        long size;
+        int mapped;
+        } TextFile;
+
+#define SECTOR_COLS  32
+#define SECTOR_ROWS  40
+
+/*-- a rectangle of hexes to draw: first absolute col, row and its size --*/
+typedef struct _view {
+        int col, row, cols, rows;
+        } View;
+
+#define NUM_HEX_PTS   7
+#define NUM_HEXES     8
+#define NUM_LINES    10
+#define HEX_PAD       4
+
+/*****************************************************************************
+ **
+ **  gen_sector() does not talk to X directly.  It draws through a Device,
+ **  a table of drawing routines that is bound either to an X drawable
+ **  (x_device) or to a client-side framebuffer (raster_device).  The pen
+ **  and font calls play the part of the XSet... calls on black_gc; PAPER
+ **  fills stand in for white_gc.
+ **
+ *****************************************************************************/
+
+#define  PAPER  0
+#define  INK    1
+
+#define  FONT_NORMAL  0
+#define  FONT_BOLD    1
+#define  FONT_SMALL   2
+#define  NUM_FONTS    3
+
+#define  SYM_NAVAL1    0
+#define  SYM_NAVAL2    1
+#define  SYM_SCOUT1    2
+#define  SYM_SCOUT2    3
+#define  SYM_DEPOT     4
+#define  SYM_ASLAN     5
+#define  SYM_CORSAIR   6
+#define  SYM_MILITARY  7
+#define  SYM_TLAUKHU   8
+#define  SYM_ZHODANE   9
+#define  NUM_SYMS     10
+
+/*-- the parts of a world draw_world_parts() can be asked to draw --*/
+#define  WORLD_SYMBOL      0x01   /* zone, disc, bases, hex, port, name */
+#define  WORLD_ALLEGIANCE  0x02
+#define  WORLD_TRADE       0x04
+#define  WORLD_UWP         0x08
+
+typedef struct _symbol {
+        char *bits;
+        int width, height;
+        } Symbol;
+
+typedef struct _device {
+        void (*pen)();        /* (dev, width, cap_style, fill_style)       */
+        void (*font)();       /* (dev, font)                               */
+        int  (*width)();      /* (dev, font, str, len)                     */
+        void (*line)();       /* (dev, x1, y1, x2, y2)                     */
+        void (*lines)();      /* (dev, points, npoints, CoordModePrevious) */
+        void (*segments)();   /* (dev, segments, nsegments)                */
+        void (*fill_rect)();  /* (dev, color, x, y, width, height)         */
+        void (*draw_rect)();  /* (dev, x, y, width, height)                */
+        void (*fill_arc)();   /* (dev, color, x, y, width, height)         */
+        void (*draw_arc)();   /* (dev, x, y, width, height)                */
+        void (*symbol)();     /* (dev, sym, x, y)                          */
+        void (*text)();       /* (dev, x, y, str, len)                     */
+        void (*flush)();      /* (dev)                                     */
+        char *data;           /* device private state                      */
+        } Device;
+
+/*****************************************************************************
+ **
+ **  The map is drawn at a scale set with '-z'.  Every length is given as
+ **  the length at scale 1, S(n), and looked up in the current Geometry,
+ **  which also holds the hex tables and the map size at that scale.
+ **
+ *****************************************************************************/
+
+#define  MIN_SCALE   0.25
+#define  MAX_SCALE   4.0
+#define  MAX_SCALES  8          /* scales kept by set_scale() at once */
+#define  MAX_PX      1200       /* S(n) is good for 0 <= n < MAX_PX   */
+
+typedef struct _geometry {
+        double scale;
+        int slot;                 /* its place among the scales kept      */
+        long used;                /* when set_scale() last chose it       */
+        int px[MAX_PX];           /* px[n]: n pixels at scale 1, scaled   */
+        int col_inc, line_inc;    /* one hex column across, one row down  */
+        int pad, map_width, map_height, print_height;
+        XPoint pts[NUM_HEX_PTS], abs_pts[NUM_HEX_PTS];
+        XPoint ctr[NUM_HEXES+8], loc[NUM_HEXES];
+        Symbol sym[NUM_SYMS];     /* base_sym scaled, on first use        */
+        } Geometry;
+
+extern Geometry *geom;
+
+#define S(n)          (geom->px[n])
+#define COL_INC       (geom->col_inc)
+#define LINE_INC      (geom->line_inc)
+#define PAD           (geom->pad)
+#define MAP_WIDTH     (geom->map_width)
+#define MAP_HEIGHT    (geom->map_height)
+#define PRINT_HEIGHT  (geom->print_height)
+#define hex_pts       (geom->pts)
+#define abs_hex_pts   (geom->abs_pts)
+#define hex_ctr       (geom->ctr)
+#define hex_loc       (geom->loc)
+
+extern int set_scale();
+extern char *scale_bitmap();
+extern Symbol *scaled_symbol();
+
+/*-- the checker tile used for borders and zones (FillTiled) --*/
+#define sm_chex_width 16
+#define sm_chex_height 16
+
+extern char sm_chex_bits[];
+extern XSegment *bdr_seg, *file_bdr_seg;
+extern Route *t_route;
+extern Border *file_bdr;
+extern World *sec_world;
+extern Symbol base_sym[];
+extern char title[], program_name[];
+extern int w_cnt, tr_cnt, bdr_cnt, private_bdr_cnt, w_max, tr_max;
+
+extern void gen_sector(), gen_sector_grid(), gen_sector_borders();
+extern void gen_sector_worlds(), draw_world_parts();
+extern int display_parts(), route_segment();
+extern int load_sector_file(), read_sector_file();
+extern void draw_world(), world_finish(), parse_sector_line(), load_bdr_seg();
+extern void load_sector_text();
+extern int open_text();
+extern void close_text();
+extern char *grow();
+extern void _swaplong(), _swapshort();
+
+/*-- the X connection and map window, set up by main() in ssv.c --*/
+extern Display *dpy;
+extern Window win;
+extern GC black_gc, white_gc;
+extern int ScrDepth, frame_stats;
+extern void repaint_info();
+extern XFontStruct *fptr;
+
+/*-- xdevice.c --*/
+extern Device *x_device(), *x_layer_device();
+extern void x_set_clip();
+extern int x_setup();
+
+/*-- layer.c --*/
+#define  LAYER_GRID     0     /* routes, hex grid and title  */
+#define  LAYER_BORDERS  1     /* ... and the zone borders    */
+#define  LAYER_WORLDS   2     /* ... and every world symbol  */
+#define  NUM_LAYERS     3
+
+extern void layer_invalidate(), layer_show(), layer_damage(), layer_repair();
+extern void layer_stale_area();
+
+/*-- damage.c --*/
+#define  ITEM_ROUTE        0
+#define  ITEM_HEX          1
+#define  ITEM_BORDER       2   /* bdr_seg, marked with the mouse */
+#define  ITEM_FILE_BORDER  3   /* file_bdr_line                  */
+#define  ITEM_WORLD        4
+#define  NUM_ITEMS         5
+
+extern XRectangle *sector_area;
+extern void sector_index_stale();
+extern int sector_find();
+extern void world_box();
+
+/*-- raster.c --*/
+#define  FORMAT_XWD     0     /* ZPixmap xwd, 8 bits (or the screen's) */
+#define  FORMAT_BITMAP  1     /* XYBitmap xwd, 1 bit                   */
+#define  FORMAT_PBM     2     /* binary PBM, 1 bit                     */
+#define  FORMAT_SVG     3     /* vector.c                              */
+#define  FORMAT_PS      4
+
+extern int out_format, out_fd;
+extern Device *raster_device(), *raster_from_image(), *raster_band();
+extern void raster_free(), raster_font_size(), raster_drop_scale();
+extern int raster_write(), raster_write_xwd(), raster_format();
+extern FILE *open_output();
+extern char *raster_extension();
+extern int raster_print_subsector();
+
+/*-- vector.c --*/
+extern Device *vector_device();
+extern int vector_close();
+
+/*-- batch.c --*/
+extern int batch_print(), batch_split();
+extern char *batch_output_name();
+
+/*-- stats.c --*/
+#define  STAT_PARSE       0   /* read_sector_file()              */
+#define  STAT_ROUTES      1   /* the steps of gen_sector()       */
+#define  STAT_GRID        2
+#define  STAT_BORDERS     3
+#define  STAT_WORLDS      4
+#define  STAT_GET_IMAGE   5   /* the phases of print_subsector() */
+#define  STAT_GET_COLORS  6
+#define  STAT_WRITE       7
+#define  NUM_STATS        8
+
+extern int stats_on;
+extern long stats_lines, stats_bytes, stats_flushes;
+extern double stats_clock();
+extern void stats_time(), stats_enable();
+
+/*-- border.c --*/
+extern XPoint *file_bdr_pts;
+extern BdrLine *file_bdr_line;
+extern int claim_radius;
+extern int border_add(), border_lines();
+extern void border_claims(), border_stale();
+
+/*-- hex.c --*/
+#define  NUM_INFO    7        /* lines of world_info() */
+#define  INFO_WIDTH  40
+
+extern void hex_index_stale();
+extern int world_at(), pixel_to_hex(), world_info(), loaded_subsector();
+
+/*-- cache.c --*/
+extern int cache_enabled, titles_read;
+extern int cache_load();
+extern void cache_begin(), cache_border(), cache_save();
+
+/*-- tab.c --*/
+extern void tab_reset();
+extern int tab_header(), tab_hex(), tab_world();
+
+/*-- label.c --*/
+extern void label_stale(), label_layout();
+extern Label *world_label();
+
+/*-- serve.c --*/
+extern int serve();
+
+/*-- watch.c --*/
+extern int watch_start();
+extern void watch_wait();
+
+/*-- route.c --*/
+extern int hex_distance(), route_print();
+extern void route_between();
+
+/*-- map.c --*/
+extern void map_extent(), map_index(), map_view_size(), gen_map();
+extern int map_load(), map_print();
@@ -0,0 +1,111 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Counters for '--stats'.  The hot paths -- parsing a
+ **                     datafile, the four steps of gen_sector() and the
+ **                     phases of writing an xwd file -- take the time with
+ **                     stats_clock() when they start and hand it back to
+ **                     stats_time() when they are done; the number of lines
+ **                     parsed, bytes written and X flushes are counted as
+ **                     they happen.  With '--stats' the totals are printed
+ **                     as one line of JSON when the program exits.  Without
+ **                     it, stats_clock() and stats_time() do nothing.
+ **
+ **  File:              stats.c, containing the following subroutines:
+ **                       stats_enable()
+ **                       stats_clock()
+ **                       stats_time()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <time.h>
+
+int stats_on = FALSE;
+long stats_lines, stats_bytes, stats_flushes;
+
+static char *stat_name[NUM_STATS] = { "parse", "routes", "grid", "borders",
+        "worlds", "get_image", "get_colors", "fwrite" };
+
+static double stat_secs[NUM_STATS];
+static long stat_calls[NUM_STATS];
+static char *stats_file;
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: stats_clock, stats_time                                         *
+ *                                                                           *
+ * Purpose:  stats_clock() returns the time now, in seconds, or 0 if the     *
+ *           counters are off; stats_time() adds the time since 'start' to   *
+ *           counter 'stat' (STAT_PARSE, ...).                               *
+ *                                                                           *
+ *****************************************************************************/
+
+double stats_clock()
+{
+  struct timespec ts;
+
+  if (!stats_on)
+    return (0.0);
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+void stats_time(stat, start)
+int stat;
+double start;
+{
+  if (!stats_on)
+    return;
+  stat_secs[stat] += stats_clock() - start;
+  stat_calls[stat]++;
+}
+
+/*-- print the totals on the stats file, or stderr; called at exit --*/
+static void stats_report()
+{
+  FILE *fd = stderr;
+  int i;
+
+  if ((stats_file != NULL) && ((fd = fopen(stats_file, "w")) == NULL)) {
+    fprintf(stderr, "%s: Cannot open %s for output\n", program_name,
+                stats_file);
+    return; }
+  fprintf(fd, "{\"lines\": %ld, \"bytes_written\": %ld, \"x_flushes\": %ld",
+        stats_lines, stats_bytes, stats_flushes);
+  for (i=0; i<NUM_STATS; i++)
+    fprintf(fd, ", \"%s\": {\"calls\": %ld, \"seconds\": %.6f}", stat_name[i],
+        stat_calls[i], stat_secs[i]);
+  fprintf(fd, "}\n");
+  if (fd != stderr)
+    fclose(fd);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  stats_enable                                                    *
+ *                                                                           *
+ * Purpose:  Turn the counters on and have the report printed at exit, to    *
+ *           file 'name', or to stderr if 'name' is NULL.                    *
+ *                                                                           *
+ *****************************************************************************/
+
+void stats_enable(name)
+char *name;
+{
+  stats_on = TRUE;
+  stats_file = name;
+  atexit(stats_report);
+}
@@ -0,0 +1,359 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Tab delimited (T5 SEC) datafiles.  Instead of the
+ **                     GEnie fixed columns, each world is a line of fields
+ **                     separated by tabs, in the order given by a header
+ **                     line of column names:
+ **
+ **                       Sector SS Hex Name UWP Bases Remarks Zone PBG
+ **                       Allegiance Stars ...
+ **
+ **                     Only the columns ssv draws from are looked for,
+ **                     by name, in any order; the others are passed over.
+ **                     A world is read into the same World record a GEnie
+ **                     line makes: the starport is the first letter of the
+ **                     UWP, the bases are folded into the one GEnie code
+ **                     ('NS' is 'A'), up to five two letter remarks are
+ **                     kept as the notes, and the allegiance is cut to two
+ **                     letters.  Title, route and border lines are as in
+ **                     any datafile.
+ **
+ **                     The tabs are found a word (8 bytes) at a time: a few
+ **                     integer operations mark the tab bytes of a word, and
+ **                     words with no mark are passed over.  The marks are
+ **                     taken lowest first where the compiler can count
+ **                     trailing zero bits of a little endian word, and
+ **                     otherwise the word is looked at byte by byte.  A
+ **                     line is split no further than its last column that
+ **                     is wanted.
+ **
+ **  File:              tab.c, containing the following subroutines:
+ **                       tab_reset()
+ **                       tab_header()
+ **                       tab_hex()
+ **                       tab_world()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <strings.h>
+
+#define TAB_FIELDS  32        /* columns of a header that are looked at */
+
+/*-- the columns that are read --*/
+#define F_HEX       0
+#define F_NAME      1
+#define F_UWP       2
+#define F_BASES     3
+#define F_REMARKS   4
+#define F_ZONE      5
+#define F_PBG       6
+#define F_ALLEG     7
+#define NUM_F       8
+
+static struct {
+        char *name;
+        int f;
+        } tab_names[] = {
+        { "Hex", F_HEX },
+        { "Name", F_NAME },
+        { "UWP", F_UWP },
+        { "Bases", F_BASES },
+        { "Base", F_BASES },
+        { "Remarks", F_REMARKS },
+        { "Zone", F_ZONE },
+        { "PBG", F_PBG },
+        { "Allegiance", F_ALLEG },
+        { NULL, 0 } };
+
+/*-- the field each column is in (-1 if it is not), and how many fields of
+     a line must be split to reach them all; none until a header is read --*/
+static int tab_col[NUM_F];
+static int tab_need = 0;
+
+/*-- a word of bytes each 'b'; and, where the compiler can say, which byte
+     of a little endian word the lowest high bit set in 't' is in --*/
+#define ONES        (~0UL / 255)
+#define BYTES(b)    (ONES * (b))
+#if defined(__GNUC__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define TAB_AT(t)   (__builtin_ctzl(t) >> 3)
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  tab_split                                                       *
+ *                                                                           *
+ * Purpose:  Find the first 'max' fields of the 'len' bytes at 'text'.       *
+ *           Field i runs from start[i] to the tab (or end of line) at       *
+ *           start[i+1] - 1; 'start' has room for max + 1 entries.  Returns  *
+ *           the number of fields found.  With x a word of the line taken    *
+ *           exclusive or with a word of tabs, a byte of x is 0 just where   *
+ *           the line has a tab, and ~(((x & 0x7f..) + 0x7f..) | x) has the  *
+ *           high bit of those bytes set and no other bits.                  *
+ *                                                                           *
+ *****************************************************************************/
+
+static int tab_split(text, len, max, start)
+char *text;
+int len, max, *start;
+{
+  unsigned long x, t;
+  int i, n = 0;
+#ifndef TAB_AT
+  int k;
+#endif
+
+  start[0] = 0;
+  for (i=0; i + (int) sizeof(x) <= len; i += sizeof(x)) {
+    memcpy((char *) &x, text + i, sizeof(x));
+    x ^= BYTES('\t');
+/*--- the high bit of each byte that was a tab, and no others ---*/
+    t = ~(((x & BYTES(0x7f)) + BYTES(0x7f)) | x) & BYTES(0x80);
+#ifdef TAB_AT
+    for (; t; t &= t - 1) {
+      start[++n] = i + TAB_AT(t) + 1;
+      if (n == max)
+        return (n);
+     }
+#else
+    for (k=0; t && (k < (int) sizeof(x)); k++)
+      if (text[i+k] == '\t') {
+        start[++n] = i + k + 1;
+        if (n == max)
+          return (n);
+       }
+#endif
+   }
+  for (; i < len; i++)
+    if (text[i] == '\t') {
+      start[++n] = i + 1;
+      if (n == max)
+        return (n);
+     }
+  start[++n] = len + 1;
+  return (n);
+}
+
+/*-- column 'f' of a line split into 'n' fields, blanks trimmed: its length,
+     with *p set to its text; an empty field if the line has no such column --*/
+static int tab_field(text, start, n, f, p)
+char *text, **p;
+int *start, n, f;
+{
+  int a, b;
+
+  *p = text;
+  if ((tab_col[f] < 0) || (tab_col[f] >= n))
+    return (0);
+  a = start[tab_col[f]];
+  b = start[tab_col[f] + 1] - 1;
+  while ((a < b) && (text[a] == ' '))
+    a++;
+  while ((b > a) && (text[b-1] == ' '))
+    b--;
+  *p = text + a;
+  return (b - a);
+}
+
+/*-- copy at most 'width' bytes of a field into a string, padding it out to
+     'width' with blanks if 'pad' is set, as a GEnie column would be --*/
+static void tab_copy(p, len, width, pad, str)
+char *p, *str;
+int len, width, pad;
+{
+  int k;
+
+  if (len > width)
+    len = width;
+  memcpy(str, p, len);
+  for (k=len; pad && (k < width); k++)
+    str[k] = ' ';
+  str[k] = '\0';
+}
+
+/*-- the GEnie base code for T5 bases: naval and scout is 'A', naval and way
+     station 'B', otherwise the first one --*/
+static int tab_base(p, len)
+char *p;
+int len;
+{
+  if ((len == 0) || (*p == '-'))
+    return (' ');
+  if (memchr(p, 'N', len) && memchr(p, 'S', len))
+    return ('A');
+  if (memchr(p, 'N', len) && memchr(p, 'W', len))
+    return ('B');
+  return (*p);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: tab_reset, tab_header                                           *
+ *                                                                           *
+ * Purpose:  Forget the columns: a new file is being read.  Take the 'len'   *
+ *           bytes at 'text' as a header line if they name at least the Hex  *
+ *           and UWP columns, and read worlds by its columns from then on;   *
+ *           returns FALSE, changing nothing, if they do not.                *
+ *                                                                           *
+ *****************************************************************************/
+
+void tab_reset()
+{
+  tab_need = 0;
+}
+
+int tab_header(text, len)
+char *text;
+int len;
+{
+  int start[TAB_FIELDS+1], col[NUM_F];
+  int i, k, n, a, b;
+
+  for (k=0; k<NUM_F; k++)
+    col[k] = -1;
+  n = tab_split(text, len, TAB_FIELDS, start);
+  for (i=0; i<n; i++) {
+    a = start[i];
+    b = start[i+1] - 1;
+    while ((a < b) && (text[a] == ' '))
+      a++;
+    while ((b > a) && (text[b-1] == ' '))
+      b--;
+    for (k=0; tab_names[k].name != NULL; k++)
+      if (((int) strlen(tab_names[k].name) == b - a) &&
+          (strncasecmp(tab_names[k].name, text + a, b - a) == 0) &&
+          (col[tab_names[k].f] < 0))
+        col[tab_names[k].f] = i;
+   }
+  if ((col[F_HEX] < 0) || (col[F_UWP] < 0))
+    return (FALSE);
+  tab_need = 0;
+  for (k=0; k<NUM_F; k++) {
+    tab_col[k] = col[k];
+    if (col[k] + 1 > tab_need)
+      tab_need = col[k] + 1;
+   }
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  tab_hex                                                         *
+ *                                                                           *
+ * Purpose:  If a header has been read and the 'len' bytes at 'text' have a  *
+ *           four digit hex in its Hex column, set 'col' and 'row' from it   *
+ *           and return TRUE (batch_split() deals out lines by it).          *
+ *                                                                           *
+ *****************************************************************************/
+
+int tab_hex(text, len, col, row)
+char *text;
+int len, *col, *row;
+{
+  int start[TAB_FIELDS+1], n, i;
+  char *p;
+
+  if (tab_need == 0)
+    return (FALSE);
+  n = tab_split(text, len, tab_col[F_HEX] + 1, start);
+  if (tab_field(text, start, n, F_HEX, &p) != 4)
+    return (FALSE);
+  for (i=0; i<4; i++)
+    if ((p[i] < '0') || (p[i] > '9'))
+      return (FALSE);
+  *col = (p[0] - '0') * 10 + (p[1] - '0');
+  *row = (p[2] - '0') * 10 + (p[3] - '0');
+  return (TRUE);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  tab_world                                                       *
+ *                                                                           *
+ * Purpose:  If a header has been read and the 'len' bytes at 'text' have a  *
+ *           four digit hex in its Hex column, add the world on them to      *
+ *           sec_world for the sector at [sx, sy] and return TRUE.  Columns  *
+ *           the header does not have, or the line stops short of, are      *
+ *           blank.                                                          *
+ *                                                                           *
+ *****************************************************************************/
+
+int tab_world(text, len, sx, sy)
+char *text;
+int len, sx, sy;
+{
+  int start[TAB_FIELDS+1], n, i, k, flen;
+  char *p, *end;
+  World *w;
+
+  if (tab_need == 0)
+    return (FALSE);
+  n = tab_split(text, len, tab_need, start);
+  if (tab_field(text, start, n, F_HEX, &p) != 4)
+    return (FALSE);
+  for (i=0; i<4; i++)
+    if ((p[i] < '0') || (p[i] > '9'))
+      return (FALSE);
+
+  sec_world = (World *) grow((char *) sec_world, &w_max, w_cnt, sizeof(World));
+  w = &sec_world[w_cnt];
+  tab_copy(p, 4, 4, TRUE, w->hex);
+
+  flen = tab_field(text, start, n, F_NAME, &p);
+  tab_copy(p, flen, sizeof(w->name) - 1, FALSE, w->name);
+
+/*--- the UWP is the starport and the 8 codes after it ---*/
+  flen = tab_field(text, start, n, F_UWP, &p);
+  tab_copy(p, flen, 1, TRUE, w->Starport);
+  if (flen > 0)
+    tab_copy(p + 1, flen - 1, 8, TRUE, w->uwp);
+  else
+    tab_copy(p, 0, 8, TRUE, w->uwp);
+
+  flen = tab_field(text, start, n, F_BASES, &p);
+  w->Base[0] = tab_base(p, flen);
+  w->Base[1] = '\0';
+
+/*--- the notes: up to 5 two letter remarks, run together ---*/
+  flen = tab_field(text, start, n, F_REMARKS, &p);
+  end = p + flen;
+  for (k=0; (p < end) && (k < 10); ) {
+    while ((p < end) && (*p == ' '))
+      p++;
+    for (i=0; (p + i < end) && (p[i] != ' '); i++);
+    if (i == 2) {
+      w->notes[k++] = p[0];
+      w->notes[k++] = p[1];
+     }
+    p += i;
+   }
+  w->notes[k] = '\0';
+
+  flen = tab_field(text, start, n, F_ZONE, &p);
+  w->Zone[0] = ((flen > 0) && ((*p == 'A') || (*p == 'R'))) ? *p : ' ';
+  w->Zone[1] = '\0';
+
+  flen = tab_field(text, start, n, F_ALLEG, &p);
+  tab_copy(p, flen, 2, TRUE, w->allegiance);
+
+  flen = tab_field(text, start, n, F_PBG, &p);
+  tab_copy(p, flen, 3, TRUE, w->pbg);
+  w->GasGiant = ((w->pbg[2] >= '0') && (w->pbg[2] <= '9')) ?
+                w->pbg[2] - '0' : 0;
+
+  world_finish(w, sx, sy);
+  return (TRUE);
+}
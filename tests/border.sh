@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# Border edges listed from both of the hexes they divide are drawn once:
+# a map of borders given from one side, from the other, from both and in
+# the other order is the same map, for the subsector ('-p') and the
+# sector ('-s'), and the SVG of both sides is the SVG of one, line for
+# line.  The borders are an open line with a branch, so the chains meet
+# at a vertex of three edges, and a closed hex: three polylines, whichever
+# order the edges come in.
+#
+# usage: tests/border.sh [path to ssv]
+
+ssv=${1:-./ssv}
+case $ssv in /*) ;; *) ssv=`pwd`/$ssv ;; esac
+dir=`mktemp -d` || exit 1
+trap 'rm -rf $dir' 0
+fail() { echo "border.sh: $*" >&2; exit 1; }
+
+cat > $dir/one <<'END'
+^0502 0
+^0502 1
+^0502 2
+^0602 0
+^1005 0
+^1005 1
+^1005 2
+^1005 3
+^1005 4
+^1005 5
+END
+cat > $dir/other <<'END'
+^0501 3
+^0601 4
+^0602 5
+^0601 3
+^1004 3
+^1105 4
+^1106 5
+^1006 0
+^0906 1
+^0905 2
+END
+cat $dir/one $dir/other > $dir/both
+sed -n '1!G;h;$p' $dir/one > $dir/reverse
+echo '#' > $dir/none
+
+cd $dir || exit 1
+for mode in p s; do
+  for f in one other both reverse none; do
+    $ssv -$mode --no-cache -f pbm -o $f.pbm $f || fail "ssv -$mode failed on $f"
+  done
+  cmp -s one.pbm none.pbm && fail "-$mode: no borders were drawn"
+  cmp -s one.pbm other.pbm || fail "-$mode: the edges from the other side differ"
+  cmp -s one.pbm both.pbm || fail "-$mode: the edges from both sides differ"
+  cmp -s one.pbm reverse.pbm || fail "-$mode: the edges in the other order differ"
+done
+for f in one both reverse; do
+  $ssv -p --no-cache -f svg -o map.svg $f || fail "ssv -p failed on $f"
+  mv map.svg $f.svg
+  [ `grep 'stroke="url(#chex)"' $f.svg | tr -cd M | wc -c` = 3 ] ||
+    fail "the borders of $f are not three polylines"
+done
+cmp -s one.svg both.svg || fail "an edge from both sides was drawn twice"
+exit 0
@@ -0,0 +1,54 @@
+#!/bin/sh
+#
+# The .ssvc cache: a map drawn from it is the map drawn from the datafile
+# ('--no-cache') when the cache is first made, after a touch that leaves
+# the text as it was, after an edit that leaves the size as it was, and
+# when the cache is of another version.  The cache must be read at all:
+# with the time and size put back after an edit, the old map comes out.
+#
+# usage: tests/cache.sh [path to ssv] [datafile]
+
+ssv=${1:-./ssv}
+data=${2:-`dirname $0`/../sec_J}
+case $ssv in /*) ;; *) ssv=`pwd`/$ssv ;; esac
+dir=`mktemp -d` || exit 1
+trap 'rm -rf $dir' 0
+fail() { echo "cache.sh: $*" >&2; exit 1; }
+
+cp $data $dir/sec || exit 1
+cd $dir || exit 1
+
+# draw 'sec' both ways; the two maps must be the same
+same() {
+  $ssv -p -f pbm -o cached.pbm sec || fail "ssv failed $1"
+  $ssv -p --no-cache -f pbm -o parsed.pbm sec || fail "ssv failed $1"
+  cmp -s cached.pbm parsed.pbm || fail "the cached map differs $1"
+}
+
+touch -t 200001010000 sec
+same "when the cache is made"
+[ -f sec.ssvc ] || fail "no cache was made"
+same "from the cache"
+cp parsed.pbm first.pbm
+
+touch -t 200001010100 sec
+same "after a touch"
+
+sed 's/^Hrunting /Hruntinx /' sec > edit && cat edit > sec && rm edit
+touch -t 200001010200 sec
+same "after a same-size edit"
+cmp -s parsed.pbm first.pbm && fail "the edit did not change the map"
+
+touch -t 200001010300 sec
+same "before the time is put back"
+sed 's/^Hruntinx /Hrunting /' sec > edit && cat edit > sec && rm edit
+touch -t 200001010300 sec
+$ssv -p -f pbm -o cached.pbm sec || fail "ssv failed"
+cmp -s cached.pbm first.pbm && fail "the cache was not read"
+
+# the cache is now stale, so only its version keeps it from being read
+printf '\377\377\377\377' | dd of=sec.ssvc bs=1 seek=4 conv=notrunc 2> /dev/null
+same "with a cache of another version"
+[ "`od -An -tx1 -j4 -N4 sec.ssvc | tr -d ' '`" != ffffffff ] ||
+  fail "the cache of another version was not made again"
+exit 0
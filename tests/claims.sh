@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+# ssv -a on two worlds of different allegiances in the same hex: the world
+# read last holds the hex, for its claim as for the sector map and the
+# inspector (hex_index), so the map is the one drawn without the first.
+#
+# usage: tests/claims.sh [path to ssv]
+
+ssv=${1:-./ssv}
+case $ssv in /*) ;; *) ssv=`pwd`/$ssv ;; esac
+dir=`mktemp -d` || exit 1
+trap 'rm -rf $dir' 0
+fail() { echo "claims.sh: $*" >&2; exit 1; }
+
+cat > $dir/both <<'END'
+Older         0102 C5039C7-9  D Po Ag De       A  134 Im G2 V
+Later         0102 C5039C7-9  D Po Ag De       A  134 Zh G2 V
+Other         0104 C5039C7-9  D Po Ag De       A  134 Im G2 V
+END
+grep -v '^Older ' $dir/both > $dir/later
+
+cd $dir || exit 1
+$ssv -s --no-cache -a 2 -f pbm -o both.pbm both || fail "ssv failed"
+$ssv -s --no-cache -a 2 -f pbm -o later.pbm later || fail "ssv failed"
+cmp -s both.pbm later.pbm || fail "the world read first kept the hex"
+exit 0
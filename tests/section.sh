@@ -0,0 +1,45 @@
+#!/bin/sh
+#
+# section(1) on a datafile with an '@' title line: the title is dropped,
+# the 16 files are sec_A..sec_P, each with one generated title, and every
+# world lands in its own subsector.  A '#SECTOR:' line starts a sector.
+#
+# usage: tests/section.sh [path to section]
+
+section=${1:-./section}
+case $section in /*) ;; *) section=`pwd`/$section ;; esac
+dir=`mktemp -d` || exit 1
+trap 'rm -rf $dir' 0
+fail() { echo "section.sh: $*" >&2; exit 1; }
+
+cat > $dir/in <<'END'
+@SUB-SECTOR: Sworld Worlds(J)   SECTOR: Spinward Marches
+#
+$0921 0922  0 0
+^0921 0
+Iscordra      0921 C5039C7-9  D Po Ag De       A  134 Im G2 V
+Lower         3240 A000000-0    Ni                000 Im M0 V
+Edge          0101 B000000-0    Ni                000 Im M0 V
+Outside       3341 B000000-0    Ni                000 Im M0 V
+END
+
+cd $dir || exit 1
+$section in 2> err || fail "section failed"
+for x in A B C D E F G H I J K L M N O P; do
+  [ -f sec_$x ] || fail "no sec_$x"
+  [ `grep -c '^@' sec_$x` = 1 ] || fail "sec_$x has more than one title"
+  head -1 sec_$x | grep -q "^@SUB-SECTOR: sec_$x   SECTOR: in$" ||
+    fail "sec_$x has the wrong title"
+done
+[ `ls | grep -c _` = 16 ] || fail "files other than sec_A..sec_P"
+grep -q '^Iscordra ' sec_J && grep -q '^Lower ' sec_P && grep -q '^Edge ' sec_A ||
+  fail "worlds in the wrong subsectors"
+grep -q 'Outside' sec_? && fail "a hex outside the sector was kept"
+grep -q '1 lines' err || fail "the skipped line was not counted"
+
+rm -f sec_?
+printf '#SECTOR: Deneb\nEdge          0101 B000000-0    Ni                000 Im M0 V\n' > two
+$section in two 2> err || fail "section failed on two files"
+[ -f in_J ] && [ -f Deneb_A ] && [ ! -f two_A ] || fail "sectors named wrongly"
+grep -q '^Edge ' Deneb_A || fail "the '#SECTOR:' sector lost its world"
+exit 0
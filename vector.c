@@ -0,0 +1,568 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       The vector Device.  It takes the same drawing calls
+ **                     gen_sector() and gen_map() make on X or on the
+ **                     framebuffer and writes them out as SVG or PostScript
+ **                     paths, so a printed map is not tied to the 770x1086
+ **                     pixel raster.  Calls with the same pen and fill are
+ **                     run together into one path.  The checker tile used
+ **                     for borders and zones becomes a pattern, and each
+ **                     base symbol is defined once, the first time it is
+ **                     drawn, as the set of its pixel runs.  Text is set in
+ **                     a monospaced font scaled to the cell size of the
+ **                     server font, over the box XDrawImageString would
+ **                     clear.
+ **
+ **  File:              vector.c, containing the following subroutines:
+ **                       vector_device()
+ **                       vector_close()
+ **                       (and the static v_... drawing routines)
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+#define  PATH_NONE    0
+#define  PATH_STROKE  1
+#define  PATH_FILL    2
+
+#define  MAX_PATH   500       /* elements in one PostScript path */
+
+/*-- the PostScript page: US letter less half inch margins, in points --*/
+#define  PAGE_WIDTH   612
+#define  PAGE_HEIGHT  792
+#define  MARGIN        36
+
+typedef struct _vector {
+        FILE *out;
+        char *name;
+        int ps;                   /* PostScript, else SVG           */
+        int width, height;
+        int pen_width, pen_cap, pen_fill, font;
+        int path;                 /* PATH_..., of the open path     */
+        int path_width, path_cap, path_paint;
+        int path_cnt;
+        char sym_done[NUM_SYMS];
+        } Vector;
+
+#define VECTOR(dev)     ((Vector *) (dev)->data)
+
+/*-- what a path is painted with: white, black or the checker tile --*/
+#define  PAINT_PAPER  0
+#define  PAINT_INK    1
+#define  PAINT_TILE   2
+
+static char *svg_paint[3] = { "#fff", "#000", "url(#chex)" };
+static char *svg_cap[3]   = { "butt", "butt", "round" };   /* CapNotLast.. */
+static char *svg_font[NUM_FONTS] = { "n", "b", "s" };
+static char *ps_font[NUM_FONTS] = { "Courier", "Courier-Bold", "Courier" };
+
+static int paint(v, color)
+Vector *v;
+int color;
+{
+  if (color == PAPER)
+    return (PAINT_PAPER);
+  return ((v->pen_fill == FillTiled) ? PAINT_TILE : PAINT_INK);
+}
+
+/*-- end the open path, painting it --*/
+static void end_path(v)
+Vector *v;
+{
+  if (v->path == PATH_NONE)
+    return;
+  if (!v->ps)
+    fprintf(v->out, "\"/>\n");
+  else if (v->path == PATH_STROKE)
+    fprintf(v->out, "stroke\n");
+  else
+    fprintf(v->out, "fill\n");
+  v->path = PATH_NONE;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  begin_path                                                      *
+ *                                                                           *
+ * Purpose:  Make sure the open path is a stroke ('kind' PATH_STROKE, with   *
+ *           the current pen) or a fill of color 'color', ending the open    *
+ *           one and starting another if it is not.  Stroked coordinates are *
+ *           then written half a pixel over, as X centers a line on the      *
+ *           middle of the pixels it sets.                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+static void begin_path(v, kind, color)
+Vector *v;
+int kind, color;
+{
+  int p, w, cap;
+
+  p = paint(v, color);
+  w = (v->pen_width <= 1) ? 1 : v->pen_width;
+  cap = (kind == PATH_STROKE) ? v->pen_cap : CapButt;
+  if ((v->path == kind) && (v->path_paint == p) && (v->path_cnt < MAX_PATH) &&
+      ((kind == PATH_FILL) || ((v->path_width == w) && (v->path_cap == cap)))) {
+    v->path_cnt++;
+    return;
+   }
+  end_path(v);
+  v->path = kind;
+  v->path_paint = p;
+  v->path_width = w;
+  v->path_cap = cap;
+  v->path_cnt = 1;
+  if (v->ps) {
+    if (kind == PATH_STROKE)
+      fprintf(v->out, "%d setlinewidth %d setlinecap ", w,
+                (cap == CapRound) ? 1 : (cap == CapProjecting) ? 2 : 0);
+    fprintf(v->out, "%s newpath\n", (p == PAINT_TILE) ? "chex setpattern" :
+                (p == PAINT_INK) ? "0 setgray" : "1 setgray");
+   }
+  else if (kind == PATH_STROKE)
+    fprintf(v->out, "<path fill=\"none\" stroke=\"%s\" stroke-width=\"%d\" "
+                "stroke-linecap=\"%s\" d=\"", svg_paint[p], w,
+                (cap == CapProjecting) ? "square" : svg_cap[cap]);
+  else
+    fprintf(v->out, "<path fill=\"%s\" d=\"", svg_paint[p]);
+}
+
+static void v_move(v, x, y)
+Vector *v;
+double x, y;
+{
+  fprintf(v->out, v->ps ? "%g %g M " : "M%g %g", x, y);
+}
+
+static void v_draw(v, x, y)
+Vector *v;
+double x, y;
+{
+  fprintf(v->out, v->ps ? "%g %g L\n" : "L%g %g", x, y);
+}
+
+static void v_ellipse(v, x, y, width, height)
+Vector *v;
+double x, y, width, height;
+{
+  double rx = width / 2.0, ry = height / 2.0;
+
+  if (v->ps)
+    fprintf(v->out, "%g %g %g %g E\n", x + rx, y + ry, rx, ry);
+  else
+    fprintf(v->out, "M%g %ga%g %g 0 1 0 %g 0a%g %g 0 1 0 %g 0z", x, y + ry,
+                rx, ry, width, rx, ry, -width);
+}
+
+static void v_rect(v, x, y, width, height)
+Vector *v;
+double x, y, width, height;
+{
+  if (v->ps)
+    fprintf(v->out, "%g %g %g %g B\n", x, y, width, height);
+  else
+    fprintf(v->out, "M%g %gh%gv%gh%gz", x, y, width, height, -width);
+}
+
+static void v_pen(dev, width, cap, fill)
+Device *dev;
+int width, cap, fill;
+{
+  VECTOR(dev)->pen_width = width;
+  VECTOR(dev)->pen_cap = cap;
+  VECTOR(dev)->pen_fill = fill;
+}
+
+static void v_font(dev, font)
+Device *dev;
+int font;
+{
+  VECTOR(dev)->font = font;
+}
+
+static int v_width(dev, font, str, len)
+Device *dev;
+int font, len;
+char *str;
+{
+  int cell, ascent, descent;
+
+  raster_font_size(font, &cell, &ascent, &descent);
+  return (cell * len);
+}
+
+static void v_line(dev, x1, y1, x2, y2)
+Device *dev;
+int x1, y1, x2, y2;
+{
+  Vector *v = VECTOR(dev);
+
+  begin_path(v, PATH_STROKE, INK);
+  v_move(v, x1 + 0.5, y1 + 0.5);
+  v_draw(v, x2 + 0.5, y2 + 0.5);
+}
+
+static void v_lines(dev, pts, n, mode)
+Device *dev;
+XPoint *pts;
+int n, mode;
+{
+  Vector *v = VECTOR(dev);
+  int i, x, y;
+
+  begin_path(v, PATH_STROKE, INK);
+  x = pts[0].x;
+  y = pts[0].y;
+  v_move(v, x + 0.5, y + 0.5);
+  for (i=1; i<n; i++) {
+    x = (mode == CoordModePrevious) ? x + pts[i].x : pts[i].x;
+    y = (mode == CoordModePrevious) ? y + pts[i].y : pts[i].y;
+    v_draw(v, x + 0.5, y + 0.5);
+   }
+}
+
+static void v_segments(dev, segs, n)
+Device *dev;
+XSegment *segs;
+int n;
+{
+  int i;
+
+  for (i=0; i<n; i++)
+    v_line(dev, segs[i].x1, segs[i].y1, segs[i].x2, segs[i].y2);
+}
+
+static void v_fill_rect(dev, color, x, y, width, height)
+Device *dev;
+int color, x, y, width, height;
+{
+  Vector *v = VECTOR(dev);
+
+  begin_path(v, PATH_FILL, color);
+  v_rect(v, (double) x, (double) y, (double) width, (double) height);
+}
+
+static void v_draw_rect(dev, x, y, width, height)
+Device *dev;
+int x, y, width, height;
+{
+  Vector *v = VECTOR(dev);
+
+  begin_path(v, PATH_STROKE, INK);
+  v_rect(v, x + 0.5, y + 0.5, (double) width, (double) height);
+}
+
+static void v_fill_arc(dev, color, x, y, width, height)
+Device *dev;
+int color, x, y, width, height;
+{
+  Vector *v = VECTOR(dev);
+
+  begin_path(v, PATH_FILL, color);
+  v_ellipse(v, (double) x, (double) y, (double) width, (double) height);
+}
+
+static void v_draw_arc(dev, x, y, width, height)
+Device *dev;
+int x, y, width, height;
+{
+  Vector *v = VECTOR(dev);
+
+  begin_path(v, PATH_STROKE, INK);
+  v_ellipse(v, (double) x, (double) y, (double) width, (double) height);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  v_symbol                                                        *
+ *                                                                           *
+ * Purpose:  Draw base symbol 'sym' with its top left corner at x,y, opaque  *
+ *           like the X Device's XCopyPlane from its atlas.  The first use   *
+ *           defines it (an SVG <symbol> or a PostScript procedure) as a     *
+ *           white box with a black rectangle for each run of set pixels in  *
+ *           its bitmap.                                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+static void v_symbol(dev, sym, x, y)
+Device *dev;
+int sym, x, y;
+{
+  Vector *v = VECTOR(dev);
+  Symbol *s = scaled_symbol(sym);
+  int i, j, run, bpl, set;
+
+  end_path(v);
+  if (!v->sym_done[sym]) {
+    v->sym_done[sym] = TRUE;
+    bpl = (s->width + 7) / 8;
+    if (v->ps)
+      fprintf(v->out, "/S%d { gsave translate 1 setgray 0 0 %d %d rectfill "
+                "0 setgray\n", sym, s->width, s->height);
+    else
+      fprintf(v->out, "<defs><g id=\"S%d\"><rect width=\"%d\" height=\"%d\" "
+                "fill=\"#fff\"/><path d=\"", sym, s->width, s->height);
+    for (j=0; j<s->height; j++) {
+      run = -1;
+      for (i=0; i<=s->width; i++) {
+        set = (i < s->width) && ((s->bits[j*bpl + (i>>3)] >> (i & 7)) & 1);
+        if (set && (run < 0))
+          run = i;
+        else if (!set && (run >= 0)) {
+          if (v->ps)
+            fprintf(v->out, "%d %d %d 1 rectfill\n", run, j, i - run);
+          else
+            fprintf(v->out, "M%d %dh%dv1h%dz", run, j, i - run, run - i);
+          run = -1;
+         }
+       }
+     }
+    fprintf(v->out, v->ps ? "grestore } bind def\n" : "\"/></g></defs>\n");
+   }
+  if (v->ps)
+    fprintf(v->out, "%d %d S%d\n", x, y, sym);
+  else
+    fprintf(v->out, "<use xlink:href=\"#S%d\" x=\"%d\" y=\"%d\"/>\n", sym, x, y);
+}
+
+/*-- 'len' characters of 'str', escaped for an SVG text node or a
+     PostScript string --*/
+static void put_text(v, str, len)
+Vector *v;
+char *str;
+int len;
+{
+  int i;
+
+  for (i=0; i<len; i++)
+    switch (str[i]) {
+      case '<'  : if (!v->ps) { fprintf(v->out, "&lt;"); break; }
+                  fputc(str[i], v->out);
+                  break;
+      case '&'  : if (!v->ps) { fprintf(v->out, "&amp;"); break; }
+                  fputc(str[i], v->out);
+                  break;
+      case '('  :
+      case ')'  :
+      case '\\' : if (v->ps) fputc('\\', v->out);
+                  fputc(str[i], v->out);
+                  break;
+      default   : fputc(((str[i] < ' ') || (str[i] > '~')) ? ' ' : str[i],
+                        v->out);
+     }
+}
+
+/*-- XDrawImageString: clear the cells, then set the string over them --*/
+static void v_text(dev, x, y, str, len)
+Device *dev;
+int x, y, len;
+char *str;
+{
+  Vector *v = VECTOR(dev);
+  int cell, ascent, descent;
+
+  raster_font_size(v->font, &cell, &ascent, &descent);
+  begin_path(v, PATH_FILL, PAPER);
+  v_rect(v, (double) x, (double) (y - ascent), (double) (cell * len),
+                (double) (ascent + descent));
+  end_path(v);
+  if (v->ps)
+    fputc('(', v->out);
+  else
+    fprintf(v->out, "<text class=\"%s\" x=\"%d\" y=\"%d\" textLength=\"%d\" "
+                "lengthAdjust=\"spacingAndGlyphs\">", svg_font[v->font], x, y,
+                cell * len);
+  put_text(v, str, len);
+  if (v->ps)
+    fprintf(v->out, ") F%d %d %d T\n", v->font, x, y);
+  else
+    fprintf(v->out, "</text>\n");
+}
+
+static void v_flush(dev)
+Device *dev;
+{
+  end_path(VECTOR(dev));
+}
+
+/*-- the checker tile as runs of INK, for the SVG pattern or PS PaintProc --*/
+static void write_tile(v)
+Vector *v;
+{
+  int i, j;
+
+  for (j=0; j<sm_chex_height; j++)
+    for (i=0; i<sm_chex_width; i++)
+      if (!((sm_chex_bits[j * 2 + (i >> 3)] >> (i & 7)) & 1))
+        fprintf(v->out, v->ps ? "%d %d 1 1 rectfill\n" : "M%d %dh1v1h-1z",
+                i, j);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  write_prologue                                                  *
+ *                                                                           *
+ * Purpose:  Start the file: the SVG root with the font classes and the      *
+ *           checker pattern, or the PostScript header, procedures, fonts    *
+ *           and a page matrix that fits the map on the page, y down as in X.*
+ *                                                                           *
+ *****************************************************************************/
+
+static void write_prologue(v)
+Vector *v;
+{
+  double scale, sx, sy;
+  int f, cell, ascent, descent;
+
+  if (!v->ps) {
+    fprintf(v->out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(v->out, "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                "xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+                "width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+                v->width, v->height, v->width, v->height);
+    fprintf(v->out, "<title>");
+    put_text(v, v->name, strlen(v->name));
+    fprintf(v->out, "</title>\n<style>text{font-family:monospace}");
+    for (f=0; f<NUM_FONTS; f++) {
+      raster_font_size(f, &cell, &ascent, &descent);
+      fprintf(v->out, ".%s{font-size:%dpx%s}", svg_font[f], ascent + descent,
+                (f == FONT_BOLD) ? ";font-weight:bold" : "");
+     }
+    fprintf(v->out, "</style>\n<defs><pattern id=\"chex\" width=\"%d\" "
+                "height=\"%d\" patternUnits=\"userSpaceOnUse\"><rect width="
+                "\"%d\" height=\"%d\" fill=\"#fff\"/><path d=\"", sm_chex_width,
+                sm_chex_height, sm_chex_width, sm_chex_height);
+    write_tile(v);
+    fprintf(v->out, "\"/></pattern></defs>\n");
+    fprintf(v->out, "<rect width=\"%d\" height=\"%d\" fill=\"#fff\"/>\n",
+                v->width, v->height);
+    return;
+   }
+
+  sx = (double) (PAGE_WIDTH - 2 * MARGIN) / v->width;
+  sy = (double) (PAGE_HEIGHT - 2 * MARGIN) / v->height;
+  scale = (sx < sy) ? sx : sy;
+  fprintf(v->out, "%%!PS-Adobe-3.0\n%%%%Title: %s\n%%%%Creator: %s\n",
+                v->name, program_name);
+  fprintf(v->out, "%%%%BoundingBox: %d %d %d %d\n%%%%LanguageLevel: 2\n",
+                MARGIN, MARGIN, MARGIN + (int) (v->width * scale + 0.999),
+                MARGIN + (int) (v->height * scale + 0.999));
+  fprintf(v->out, "%%%%Pages: 1\n%%%%EndComments\n%%%%BeginProlog\n");
+  fprintf(v->out, "/M { moveto } bind def\n/L { lineto } bind def\n");
+  fprintf(v->out, "/B { 4 2 roll moveto 1 index 0 rlineto 0 exch rlineto "
+                "neg 0 rlineto closepath } bind def\n");
+  fprintf(v->out, "/E { matrix currentmatrix 5 1 roll 4 2 roll translate "
+                "scale 1 0 moveto 0 0 1 0 360 arc closepath setmatrix } "
+                "bind def\n");
+  fprintf(v->out, "/T { moveto setfont 0 setgray show } bind def\n");
+  for (f=0; f<NUM_FONTS; f++) {
+    raster_font_size(f, &cell, &ascent, &descent);
+    fprintf(v->out, "/F%d /%s findfont [%g 0 0 %d 0 0] makefont def\n", f,
+                ps_font[f], cell / 0.6, -(ascent + descent));
+   }
+  fprintf(v->out, "%%%%EndProlog\n%%%%Page: 1 1\n");
+  fprintf(v->out, "%d %g translate %g %g scale\n", MARGIN,
+                MARGIN + v->height * scale, scale, -scale);
+  fprintf(v->out, "/chex << /PatternType 1 /PaintType 1 /TilingType 1 "
+                "/BBox [0 0 %d %d] /XStep %d /YStep %d /PaintProc { pop\n"
+                "1 setgray 0 0 %d %d rectfill 0 setgray\n", sm_chex_width,
+                sm_chex_height, sm_chex_width, sm_chex_height, sm_chex_width,
+                sm_chex_height);
+  write_tile(v);
+  fprintf(v->out, "} >> matrix makepattern def\n");
+  fprintf(v->out, "1 setgray 0 0 %d %d rectfill 0 setlinejoin\n", v->width,
+                v->height);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: vector_device, vector_close                                     *
+ *                                                                           *
+ * Purpose:  vector_device() opens 'name' and returns a Device that writes   *
+ *           a width x height map to it, as SVG or (if 'ps' is set) as       *
+ *           PostScript; NULL if it cannot.  vector_close() ends the file    *
+ *           and frees the Device, returning FALSE if the file could not be  *
+ *           written.                                                        *
+ *                                                                           *
+ *****************************************************************************/
+
+Device *vector_device(name, width, height, ps)
+char *name;
+int width, height, ps;
+{
+  Device *dev;
+  Vector *v;
+
+  dev = (Device *) malloc(sizeof(Device));
+  v = (Vector *) calloc(1, sizeof(Vector));
+  if ((dev == NULL) || (v == NULL))
+    return (NULL);
+  if ((v->out = open_output(name)) == NULL) {
+    free((char *) v);
+    free((char *) dev);
+    return (NULL);
+   }
+  v->name = name;
+  v->ps = ps;
+  v->width = width;
+  v->height = height;
+  v->pen_width = 1;
+  v->pen_cap = CapButt;
+  v->pen_fill = FillSolid;
+  v->font = FONT_NORMAL;
+  v->path = PATH_NONE;
+
+  dev->pen = v_pen;
+  dev->font = v_font;
+  dev->width = v_width;
+  dev->line = v_line;
+  dev->lines = v_lines;
+  dev->segments = v_segments;
+  dev->fill_rect = v_fill_rect;
+  dev->draw_rect = v_draw_rect;
+  dev->fill_arc = v_fill_arc;
+  dev->draw_arc = v_draw_arc;
+  dev->symbol = v_symbol;
+  dev->text = v_text;
+  dev->flush = v_flush;
+  dev->data = (char *) v;
+  write_prologue(v);
+  return (dev);
+}
+
+int vector_close(dev)
+Device *dev;
+{
+  Vector *v = VECTOR(dev);
+  double start;
+  long bytes;
+  int status;
+
+  start = stats_clock();
+  end_path(v);
+  fprintf(v->out, v->ps ? "showpage\n%%%%EOF\n" : "</svg>\n");
+/*--- a socket (serve) has no position to count the bytes by ---*/
+  if ((bytes = ftell(v->out)) > 0)
+    stats_bytes += bytes;
+  status = !ferror(v->out);
+  if (fclose(v->out) != 0)
+    status = FALSE;
+  stats_time(STAT_WRITE, start);
+  free(dev->data);
+  free((char *) dev);
+  return (status);
+}
@@ -0,0 +1,384 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       Watch mode ('--watch').  The directory of the
+ **                     datafile is watched with inotify, and when the file
+ **                     is written (or an editor renames a new copy over
+ **                     it) it is read again.  The new worlds, routes and
+ **                     file borders are compared with the old ones, hex by
+ **                     hex, and only the parts of the map they cover are
+ **                     marked out of date and repainted; the borders marked
+ **                     with the mouse are kept.
+ **
+ **  File:              watch.c, containing the following subroutines:
+ **                       watch_start()
+ **                       watch_wait()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <sys/inotify.h>
+
+#define NUM_SUB_HEXES  (NUM_HEXES * NUM_LINES)
+
+static char *watch_dir, *watch_base;
+
+/*-- what was loaded before the file changed, and copies of the new routes
+     and borders to sort --*/
+static World *old_world;
+static Route *old_route, *new_route;
+static XSegment *old_bdr, *new_bdr;
+static Border *old_file_bdr;
+static int old_w_cnt, old_tr_cnt, old_bdr_cnt;
+static int old_w_max, old_tr_max, old_bdr_max, new_tr_max, new_bdr_max;
+static int old_file_max;
+static char old_title[80];
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  watch_start                                                     *
+ *                                                                           *
+ * Purpose:  Start watching datafile 'name'.  Its directory is watched, not  *
+ *           the file, as most editors write a new file and rename it over   *
+ *           the old one.  Returns the inotify descriptor, or -1.            *
+ *                                                                           *
+ *****************************************************************************/
+
+int watch_start(name)
+char *name;
+{
+  char *slash;
+  int fd;
+
+  if ((watch_dir = malloc(strlen(name) + 2)) == NULL) {
+    fprintf(stderr, "%s: Out of memory\n", program_name);
+    exit(1); }
+  strcpy(watch_dir, name);
+  if ((slash = strrchr(watch_dir, '/')) != NULL) {
+    *slash = '\0';
+    watch_base = name + (slash - watch_dir) + 1;
+    if (watch_dir[0] == '\0')
+      strcpy(watch_dir, "/");
+   }
+  else {
+    strcpy(watch_dir, ".");
+    watch_base = name;
+   }
+  if ((fd = inotify_init()) < 0)
+    return (-1);
+  if (inotify_add_watch(fd, watch_dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    close(fd);
+    return (-1);
+   }
+  return (fd);
+}
+
+/*-- TRUE if any of the events waiting on 'fd' is about the datafile --*/
+static int watch_changed(fd)
+int fd;
+{
+  char buf[4096];
+  struct inotify_event *ev;
+  int n, i, changed = FALSE;
+
+  if ((n = read(fd, buf, sizeof(buf))) <= 0)
+    return (FALSE);
+  for (i=0; i<n; i+=sizeof(struct inotify_event) + ev->len) {
+    ev = (struct inotify_event *) &buf[i];
+    if ((ev->len > 0) && (strcmp(ev->name, watch_base) == 0))
+      changed = TRUE;
+   }
+  return (changed);
+}
+
+/*****************************************************************************
+ **
+ **  The worlds are compared hex by hex, through a hash of everything drawn
+ **  for the worlds in each of the 80 hexes of the subsector; a hex whose
+ **  hash differs has the old and new boxes of its worlds repainted.  The
+ **  routes and file borders are compared as sorted lists, and one only in
+ **  the old list or only in the new is repainted.
+ **
+ *****************************************************************************/
+
+static unsigned hash_str(h, s, n)
+unsigned h;
+char *s;
+int n;
+{
+  for (; (n > 0) && *s; n--, s++)
+    h = (h ^ (unsigned char) *s) * 16777619u;
+  return ((h ^ 0xff) * 16777619u);
+}
+
+static void hash_hexes(w, cnt, sig)
+World *w;
+int cnt;
+unsigned *sig;
+{
+  int i, k;
+  unsigned h;
+
+  for (k=0; k<NUM_SUB_HEXES; k++)
+    sig[k] = 2166136261u;
+  for (i=0; i<cnt; i++, w++) {
+    k = w->location.y * NUM_HEXES + w->location.x;
+    if ((k < 0) || (k >= NUM_SUB_HEXES))
+      continue;
+    h = sig[k];
+    h = (h ^ (unsigned) w->WorldType) * 16777619u;
+    h = (h ^ (unsigned) w->GasGiant) * 16777619u;
+    h = hash_str(h, w->Starport, sizeof(w->Starport));
+    h = hash_str(h, w->Base, sizeof(w->Base));
+    h = hash_str(h, w->Zone, sizeof(w->Zone));
+    h = hash_str(h, w->hex, sizeof(w->hex));
+    h = hash_str(h, w->name, sizeof(w->name));
+    h = hash_str(h, w->uwp, sizeof(w->uwp));
+    h = hash_str(h, w->notes, sizeof(w->notes));
+    h = hash_str(h, w->allegiance, sizeof(w->allegiance));
+    sig[k] = h;
+   }
+}
+
+static void damage_box(b)
+XRectangle *b;
+{
+  layer_stale_area(b->x, b->y, b->width, b->height);
+}
+
+/*-- repaint the worlds of 'w' in hexes whose hash has changed --*/
+static int damage_worlds(dev, w, cnt, changed)
+Device *dev;
+World *w;
+int cnt;
+char *changed;
+{
+  XRectangle b;
+  int i, k, n = 0;
+
+  for (i=0; i<cnt; i++, w++) {
+    k = w->location.y * NUM_HEXES + w->location.x;
+    if ((k < 0) || (k >= NUM_SUB_HEXES) || !changed[k])
+      continue;
+    world_box(dev, w, &b);
+    damage_box(&b);
+    n++;
+   }
+  return (n);
+}
+
+static int by_route(a, b)
+Route *a, *b;
+{
+  int d;
+
+  if ((d = a->x1 - b->x1) != 0) return (d);
+  if ((d = a->y1 - b->y1) != 0) return (d);
+  if ((d = a->x2 - b->x2) != 0) return (d);
+  return (a->y2 - b->y2);
+}
+
+static int by_segment(a, b)
+XSegment *a, *b;
+{
+  int d;
+
+  if ((d = a->x1 - b->x1) != 0) return (d);
+  if ((d = a->y1 - b->y1) != 0) return (d);
+  if ((d = a->x2 - b->x2) != 0) return (d);
+  return (a->y2 - b->y2);
+}
+
+static void damage_route(rt)
+Route *rt;
+{
+  XSegment seg;
+  int x, y;
+
+  if (!route_segment(rt, &seg))
+    return;
+  x = (seg.x1 < seg.x2) ? seg.x1 : seg.x2;
+  y = (seg.y1 < seg.y2) ? seg.y1 : seg.y2;
+  layer_stale_area(x - S(3), y - S(3), abs(seg.x2 - seg.x1) + 2 * S(3) + 1,
+                abs(seg.y2 - seg.y1) + 2 * S(3) + 1);
+}
+
+static void damage_segment(s)
+XSegment *s;
+{
+  int x, y;
+
+  x = (s->x1 < s->x2) ? s->x1 : s->x2;
+  y = (s->y1 < s->y2) ? s->y1 : s->y2;
+  layer_stale_area(x - S(3), y - S(3), abs(s->x2 - s->x1) + 2 * S(3) + 1,
+                abs(s->y2 - s->y1) + 2 * S(3) + 1);
+}
+
+/*-- merge the sorted old and new lists, repainting what is in only one;
+     returns how many differ --*/
+static int diff_list(old, old_cnt, new, new_cnt, size, cmp, damage)
+char *old, *new;
+int old_cnt, new_cnt, size;
+int (*cmp)();
+void (*damage)();
+{
+  int i = 0, k = 0, d, n = 0;
+
+  qsort(old, old_cnt, size, cmp);
+  qsort(new, new_cnt, size, cmp);
+  while ((i < old_cnt) || (k < new_cnt)) {
+    if (i == old_cnt)
+      d = 1;
+    else if (k == new_cnt)
+      d = -1;
+    else
+      d = (*cmp)(old + i * size, new + k * size);
+    if (d < 0)
+      (*damage)(old + (i++) * size);
+    else if (d > 0)
+      (*damage)(new + (k++) * size);
+    else {
+      i++;
+      k++;
+      continue;
+     }
+    n++;
+   }
+  return (n);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  watch_reload                                                    *
+ *                                                                           *
+ * Purpose:  Read datafile 'name' again and repaint what changed.  If it     *
+ *           cannot be read (it may be half written), the old data is kept.  *
+ *                                                                           *
+ *****************************************************************************/
+
+static void watch_reload(name)
+char *name;
+{
+  unsigned old_sig[NUM_SUB_HEXES], new_sig[NUM_SUB_HEXES];
+  char changed[NUM_SUB_HEXES];
+  struct timeval start, end;
+  Device *dev;
+  int k, keep_bdr, hexes, routes, borders;
+
+/*--- keep a copy of what is loaded, to compare and to put back: a load ---*/
+/*--- that fails part way has already written over the arrays          ---*/
+  gettimeofday(&start, NULL);
+  old_world = (World *) grow((char *) old_world, &old_w_max, w_cnt,
+                sizeof(World));
+  old_route = (Route *) grow((char *) old_route, &old_tr_max, tr_cnt,
+                sizeof(Route));
+  old_bdr = (XSegment *) grow((char *) old_bdr, &old_bdr_max,
+                private_bdr_cnt, sizeof(XSegment));
+  memcpy(old_world, sec_world, w_cnt * sizeof(World));
+  memcpy(old_route, t_route, tr_cnt * sizeof(Route));
+  old_file_bdr = (Border *) grow((char *) old_file_bdr, &old_file_max,
+                private_bdr_cnt, sizeof(Border));
+  memcpy(old_bdr, file_bdr_seg, private_bdr_cnt * sizeof(XSegment));
+  memcpy(old_file_bdr, file_bdr, private_bdr_cnt * sizeof(Border));
+  old_w_cnt = w_cnt;
+  old_tr_cnt = tr_cnt;
+  old_bdr_cnt = private_bdr_cnt;
+  strncpy(old_title, title, sizeof(old_title) - 1);
+  old_title[sizeof(old_title) - 1] = '\0';
+
+  keep_bdr = bdr_cnt;
+  if (!load_sector_file(name)) {
+    fprintf(stderr, "%s: Cannot read \"%s\", keeping the old map\n",
+                program_name, name);
+    memcpy(sec_world, old_world, old_w_cnt * sizeof(World));
+    memcpy(t_route, old_route, old_tr_cnt * sizeof(Route));
+    if (old_bdr_cnt > 0) {
+      memcpy(file_bdr_seg, old_bdr, old_bdr_cnt * sizeof(XSegment));
+      memcpy(file_bdr, old_file_bdr, old_bdr_cnt * sizeof(Border));
+     }
+    w_cnt = old_w_cnt;
+    tr_cnt = old_tr_cnt;
+    private_bdr_cnt = old_bdr_cnt;
+    bdr_cnt = keep_bdr;
+    strncpy(title, old_title, sizeof(old_title) - 1);
+    title[sizeof(old_title) - 1] = '\0';
+    border_stale();
+    hex_index_stale();
+    label_stale();
+    sector_index_stale();
+    return;
+   }
+  bdr_cnt = keep_bdr;
+  sector_index_stale();
+  new_route = (Route *) grow((char *) new_route, &new_tr_max, tr_cnt,
+                sizeof(Route));
+  new_bdr = (XSegment *) grow((char *) new_bdr, &new_bdr_max,
+                private_bdr_cnt, sizeof(XSegment));
+  memcpy(new_route, t_route, tr_cnt * sizeof(Route));
+  memcpy(new_bdr, file_bdr_seg, private_bdr_cnt * sizeof(XSegment));
+
+  dev = x_device(win);
+  hash_hexes(old_world, old_w_cnt, old_sig);
+  hash_hexes(sec_world, w_cnt, new_sig);
+  for (k=0; k<NUM_SUB_HEXES; k++)
+    changed[k] = (old_sig[k] != new_sig[k]);
+  hexes = damage_worlds(dev, old_world, old_w_cnt, changed) +
+          damage_worlds(dev, sec_world, w_cnt, changed);
+  routes = diff_list((char *) old_route, old_tr_cnt, (char *) new_route,
+                tr_cnt, sizeof(Route), by_route, damage_route);
+  borders = diff_list((char *) old_bdr, old_bdr_cnt, (char *) new_bdr,
+                private_bdr_cnt, sizeof(XSegment), by_segment, damage_segment);
+  if (strcmp(old_title, title) != 0)
+    layer_stale_area(0, 0, MAP_WIDTH, S(10) + PAD);
+  layer_repair(win, display_parts());
+  repaint_info();
+  if (frame_stats) {
+    gettimeofday(&end, NULL);
+    fprintf(stderr, "%s: reload: %d worlds, %d routes, %d borders changed, "
+                "%.1f ms\n", program_name, hexes, routes, borders,
+                (end.tv_sec - start.tv_sec) * 1000.0 +
+                (end.tv_usec - start.tv_usec) / 1000.0);
+   }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  watch_wait                                                      *
+ *                                                                           *
+ * Purpose:  Wait until there is an X event to read, reloading datafile      *
+ *           'name' whenever inotify descriptor 'fd' says it has changed.    *
+ *                                                                           *
+ *****************************************************************************/
+
+void watch_wait(fd, name)
+int fd;
+char *name;
+{
+  fd_set fds;
+  int xfd = ConnectionNumber(dpy);
+
+  while (XPending(dpy) == 0) {
+    FD_ZERO(&fds);
+    FD_SET(xfd, &fds);
+    FD_SET(fd, &fds);
+    if (select(((fd > xfd) ? fd : xfd) + 1, &fds, NULL, NULL, NULL) < 0)
+      continue;
+    if (FD_ISSET(fd, &fds) && watch_changed(fd))
+      watch_reload(name);
+   }
+}
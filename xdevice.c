@@ -0,0 +1,660 @@
+/******************************************************************************
+ **  Program:           ssv
+ **
+ **  Description:       The X Device.  Drawing calls are not sent to the
+ **                     server one at a time: each is recorded in a display
+ **                     list, filed under the GC state it needs (pen, fill
+ **                     style, colour or font), and the list is sent when
+ **                     gen_sector() flushes the device at the end of a step.
+ **                     Everything drawn with one state then goes out as one
+ **                     request: the hex grid as a single XDrawSegments, the
+ **                     world discs as XFillArcs, the zones as XFillArcs and
+ **                     XDrawArcs, and each text class after a single font
+ **                     switch.
+ **
+ **                     The list is sent in a fixed order of classes: tiled
+ **                     zones and borders, then PAPER fills, then solid ink,
+ **                     then base symbols, then the normal, bold and small
+ **                     text.  That is the order draw_world() draws the
+ **                     parts of one world in, and the parts of different
+ **                     worlds do not overlap, so the picture is the one the
+ **                     calls would have drawn one at a time.
+ **
+ **  File:              xdevice.c, containing the following subroutines:
+ **                       x_device()
+ **                       x_layer_device()
+ **                       x_set_clip()
+ **                       x_setup()
+ **
+ **  Copyright 1990 by Mark F. Cook and Hewlett-Packard,
+ **                             Interface Technology Operation
+ **
+ **  Permission to use, copy, and modify this software is granted, provided
+ **  that this copyright appears in all copies and that both this copyright
+ **  and permission notice appear in all supporting documentation, and that
+ **  the name of Mark F. Cook and/or Hewlett-Packard not be used in advertising
+ **  without specific, writen prior permission.  Neither Mark F. Cook or
+ **  Hewlett-Packard make any representations about the suitibility of this
+ **  software for any purpose.  It is provided "as is" without express or
+ **  implied warranty.
+ **
+ *****************************************************************************/
+
+#include "ssv.h"
+
+/******************************
+#define NORMAL_FONT "hp8.8x16"
+#define BOLD_FONT   "hp8.8x16b"
+******************************/
+
+/*
+#define NORMAL_FONT "iso1.16"
+#define BOLD_FONT   "iso1.16b"
+*/
+#define NORMAL_FONT "8x13"
+#define BOLD_FONT   "8x13bold"
+#define SMALL_FONT  "6x10"
+
+#define  OP_SEGMENT    0
+#define  OP_FILL_ARC   1
+#define  OP_DRAW_ARC   2
+#define  OP_FILL_RECT  3
+#define  OP_DRAW_RECT  4
+#define  OP_SYMBOL     5
+#define  OP_TEXT       6
+
+#define  MAX_BUCKETS  32
+
+/*-- one recorded drawing call --*/
+typedef struct _op {
+        short x, y, w, h;          /* segment: x1, y1, x2, y2 */
+        short sym;
+        char *str;
+        int len;
+        int next;                  /* next op in the same bucket, or -1 */
+        } Op;
+
+/*-- the calls that can go out in one request: same kind, same GC state --*/
+typedef struct _bucket {
+        int kind, width, cap, fill, color, font;
+        int class;
+        int first, last;
+        } Bucket;
+
+static char *font_name[NUM_FONTS] = { NORMAL_FONT, BOLD_FONT, SMALL_FONT };
+static XFontStruct *x_fonts[NUM_FONTS];
+static Drawable x_root, x_drawable;
+static Pixmap x_mask;
+static GC mask_gc;
+static XRectangle *x_clip;
+
+static int pen_width = 1, pen_cap = CapButt, pen_fill = FillSolid;
+static int cur_font = FONT_NORMAL;
+
+static Op *op;
+static int op_cnt, op_max;
+static Bucket bucket[MAX_BUCKETS];
+static int bucket_cnt;
+
+/*-- scratch arrays the buckets are packed into --*/
+static XSegment *segs;
+static XArc *arcs;
+static XRectangle *rects, *mask_rects;
+static int segs_max, arcs_max, rects_max, mask_max, mask_cnt;
+
+/*-- the base symbols, side by side in one depth 1 pixmap; each is put in
+     the first time it is drawn --*/
+static Pixmap sym_atlas = None;
+static GC atlas_gc;
+static int atlas_x[NUM_SYMS], atlas_has[NUM_SYMS];
+
+static void x_send();
+static XFontStruct *x_scaled_font();
+
+/*-- font 'font' at the current scale, loaded the first time it is used.
+     A bold or small font the server does not have is replaced by the
+     normal one --*/
+static XFontStruct *x_font_at(font)
+int font;
+{
+  XFontStruct *f;
+
+  if (x_fonts[font] != NULL)
+    return (x_fonts[font]);
+  if (font == FONT_NORMAL)
+    f = fptr;
+  else if ((f = XLoadQueryFont(dpy, font_name[font])) == NULL) {
+    fprintf(stderr, "%s: Cannot open font \"%s\", using \"%s\"\n",
+                program_name, font_name[font], font_name[FONT_NORMAL]);
+    return (x_fonts[font] = x_font_at(FONT_NORMAL));
+   }
+  if (geom->scale != 1.0)
+    f = x_scaled_font(f, font == FONT_BOLD);
+  return (x_fonts[font] = f);
+}
+
+/*-- the x offset of base symbol 'sym' in sym_atlas, making the atlas and
+     putting the symbol in it if need be --*/
+static int x_atlas(sym)
+int sym;
+{
+  XImage *img;
+  Symbol *s;
+  int i, width, height;
+
+  if (sym_atlas == None) {
+    width = height = 0;
+    for (i=0; i<NUM_SYMS; i++) {
+      s = scaled_symbol(i);
+      atlas_x[i] = width;
+      width += s->width;
+      if (s->height > height)
+        height = s->height;
+     }
+    sym_atlas = XCreatePixmap(dpy, x_root, width, height, 1);
+    atlas_gc = XCreateGC(dpy, sym_atlas, 0, 0);
+    XSetForeground(dpy, atlas_gc, 1);
+    XSetBackground(dpy, atlas_gc, 0);
+   }
+  if (!atlas_has[sym]) {
+/*--- the bits are in xbm order, as XCreateBitmapFromData takes them ---*/
+    s = scaled_symbol(sym);
+    img = XCreateImage(dpy, (Visual *) NULL, 1, XYBitmap, 0, s->bits,
+                s->width, s->height, 8, 0);
+    img->byte_order = LSBFirst;
+    img->bitmap_bit_order = LSBFirst;
+    XPutImage(dpy, sym_atlas, atlas_gc, img, 0, 0, atlas_x[sym], 0,
+                s->width, s->height);
+    img->data = NULL;
+    XDestroyImage(img);
+    atlas_has[sym] = TRUE;
+   }
+  return (atlas_x[sym]);
+}
+
+/*-- which parts of the GC state a call depends on: symbols and image text
+     use neither the pen nor the fill style, fills do not use the pen, and
+     PAPER fills are done with white_gc, which never changes --*/
+static int uses_pen(kind)
+int kind;
+{
+  return ((kind == OP_SEGMENT) || (kind == OP_DRAW_ARC) ||
+          (kind == OP_DRAW_RECT));
+}
+
+static int uses_fill(kind, color)
+int kind, color;
+{
+  if ((kind == OP_SYMBOL) || (kind == OP_TEXT))
+    return (FALSE);
+  return (uses_pen(kind) || (color == INK));
+}
+
+/*-- the order classes are sent in (see above) --*/
+static int op_class(kind, fill, color, font)
+int kind, fill, color, font;
+{
+  if (kind == OP_TEXT)
+    return (4 + font);
+  if (kind == OP_SYMBOL)
+    return (3);
+  if (((kind == OP_FILL_ARC) || (kind == OP_FILL_RECT)) && (color == PAPER))
+    return (1);
+  return ((fill == FillTiled) ? 0 : 2);
+}
+
+/*-- record a call of 'kind' with the current GC state; returns its Op --*/
+static Op *x_record(kind, color)
+int kind, color;
+{
+  Bucket *b;
+  Op *o;
+  int i, font;
+
+  font = (kind == OP_TEXT) ? cur_font : 0;
+  for (i=0; i<bucket_cnt; i++) {
+    b = &bucket[i];
+    if ((b->kind == kind) && (b->color == color) && (b->font == font) &&
+        (!uses_fill(kind, color) || (b->fill == pen_fill)) &&
+        (!uses_pen(kind) || ((b->width == pen_width) && (b->cap == pen_cap))))
+      break;
+   }
+  if (i == bucket_cnt) {
+    if (bucket_cnt == MAX_BUCKETS)
+      x_send();
+    b = &bucket[bucket_cnt++];
+    b->kind = kind;
+    b->width = pen_width;
+    b->cap = pen_cap;
+    b->fill = pen_fill;
+    b->color = color;
+    b->font = font;
+    b->class = op_class(kind, pen_fill, color, font);
+    b->first = -1;
+   }
+  op = (Op *) grow((char *) op, &op_max, op_cnt, sizeof(Op));
+  o = &op[op_cnt];
+  o->next = -1;
+  if (b->first < 0)
+    b->first = op_cnt;
+  else
+    op[b->last].next = op_cnt;
+  b->last = op_cnt++;
+  return (o);
+}
+
+/*-- put the recorded pen and fill style into black_gc --*/
+static void x_gc_pen(width, cap, fill)
+int width, cap, fill;
+{
+  XSetLineAttributes(dpy, black_gc, width, LineSolid, cap, JoinMiter);
+  XSetFillStyle(dpy, black_gc, fill);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  x_send                                                          *
+ *                                                                           *
+ * Purpose:  Send the display list to the server, one bucket at a time in    *
+ *           class order, and empty it.  black_gc is left with the pen and   *
+ *           font the device was last set to, as if every call had gone out  *
+ *           on its own.                                                     *
+ *                                                                           *
+ *****************************************************************************/
+
+static void x_send()
+{
+  int c, i, j, k, n, gc_width, gc_cap, gc_fill, gc_font;
+  Bucket *b;
+  Op *o;
+  GC gc;
+
+  gc_width = gc_cap = gc_fill = gc_font = -1;
+  for (c=0; c<4+NUM_FONTS; c++)
+    for (i=0; i<bucket_cnt; i++) {
+      b = &bucket[i];
+      if (b->class != c)
+        continue;
+      gc = black_gc;
+      if (((b->kind == OP_FILL_ARC) || (b->kind == OP_FILL_RECT)) &&
+          (b->color == PAPER))
+        gc = white_gc;
+      else if (uses_fill(b->kind, b->color) &&
+               ((b->fill != gc_fill) || (uses_pen(b->kind) &&
+                ((b->width != gc_width) || (b->cap != gc_cap))))) {
+        gc_width = b->width;
+        gc_cap = b->cap;
+        gc_fill = b->fill;
+        x_gc_pen(gc_width, gc_cap, gc_fill);
+       }
+      if ((b->kind == OP_TEXT) && (b->font != gc_font)) {
+        gc_font = b->font;
+        XSetFont(dpy, black_gc, x_font_at(gc_font)->fid);
+       }
+
+      n = 0;
+      for (j=b->first; j>=0; j=op[j].next) {
+        o = &op[j];
+        switch (b->kind) {
+          case OP_SEGMENT   : segs = (XSegment *) grow((char *) segs,
+                                        &segs_max, n, sizeof(XSegment));
+                              segs[n].x1 = o->x;
+                              segs[n].y1 = o->y;
+                              segs[n].x2 = o->w;
+                              segs[n++].y2 = o->h;
+                              break;
+          case OP_FILL_ARC  :
+          case OP_DRAW_ARC  : arcs = (XArc *) grow((char *) arcs, &arcs_max,
+                                        n, sizeof(XArc));
+                              arcs[n].x = o->x;
+                              arcs[n].y = o->y;
+                              arcs[n].width = o->w;
+                              arcs[n].height = o->h;
+                              arcs[n].angle1 = 0;
+                              arcs[n++].angle2 = 360*64;
+                              break;
+          case OP_FILL_RECT :
+          case OP_DRAW_RECT : rects = (XRectangle *) grow((char *) rects,
+                                        &rects_max, n, sizeof(XRectangle));
+                              rects[n].x = o->x;
+                              rects[n].y = o->y;
+                              rects[n].width = o->w;
+                              rects[n++].height = o->h;
+                              break;
+          case OP_SYMBOL    : k = x_atlas(o->sym);
+                              XCopyPlane(dpy, sym_atlas, x_drawable,
+                                        black_gc, k, 0,
+                                        geom->sym[o->sym].width,
+                                        geom->sym[o->sym].height, o->x, o->y,
+                                        1L);
+                              break;
+          case OP_TEXT      : XDrawImageString(dpy, x_drawable, black_gc,
+                                        o->x, o->y, o->str, o->len);
+                              break;
+         }
+       }
+      switch (b->kind) {
+        case OP_SEGMENT   : XDrawSegments(dpy, x_drawable, gc, segs, n);
+                            break;
+        case OP_FILL_ARC  : XFillArcs(dpy, x_drawable, gc, arcs, n);
+                            break;
+        case OP_DRAW_ARC  : XDrawArcs(dpy, x_drawable, gc, arcs, n);
+                            break;
+        case OP_FILL_RECT : XFillRectangles(dpy, x_drawable, gc, rects, n);
+                            break;
+        case OP_DRAW_RECT : XDrawRectangles(dpy, x_drawable, gc, rects, n);
+                            break;
+       }
+     }
+  if (mask_cnt > 0)
+    XFillRectangles(dpy, x_mask, mask_gc, mask_rects, mask_cnt);
+
+  if ((gc_fill >= 0) &&
+      ((gc_width != pen_width) || (gc_cap != pen_cap) || (gc_fill != pen_fill)))
+    x_gc_pen(pen_width, pen_cap, pen_fill);
+  if ((gc_font >= 0) && (gc_font != cur_font))
+    XSetFont(dpy, black_gc, x_font_at(cur_font)->fid);
+  op_cnt = 0;
+  bucket_cnt = 0;
+  mask_cnt = 0;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: the x_... drawing routines                                      *
+ *                                                                           *
+ * Purpose:  Record one call each.  The pen and font calls only change the   *
+ *           state the following calls are filed under.                      *
+ *                                                                           *
+ *****************************************************************************/
+
+static void x_pen(dev, width, cap, fill)
+Device *dev;
+int width, cap, fill;
+{
+  pen_width = width;
+  pen_cap = cap;
+  pen_fill = fill;
+}
+
+static void x_font(dev, font)
+Device *dev;
+int font;
+{
+  cur_font = font;
+}
+
+static int x_width(dev, font, str, len)
+Device *dev;
+int font, len;
+char *str;
+{
+  return (XTextWidth(x_font_at(font), str, len));
+}
+
+static void x_line(dev, x1, y1, x2, y2)
+Device *dev;
+int x1, y1, x2, y2;
+{
+  Op *o = x_record(OP_SEGMENT, INK);
+
+  o->x = x1;
+  o->y = y1;
+  o->w = x2;
+  o->h = y2;
+}
+
+/*-- thin polylines are filed as their segments; a wide one needs its
+     joins, so it goes out on its own after whatever came before it --*/
+static void x_lines(dev, pts, n, mode)
+Device *dev;
+XPoint *pts;
+int n, mode;
+{
+  int i, x, y;
+
+  if (pen_width > 0) {
+    x_send();
+    x_gc_pen(pen_width, pen_cap, pen_fill);
+    XDrawLines(dpy, x_drawable, black_gc, pts, n, mode);
+    return;
+   }
+  x = pts[0].x;
+  y = pts[0].y;
+  for (i=1; i<n; i++) {
+    if (mode == CoordModePrevious)
+      x_line(dev, x, y, x + pts[i].x, y + pts[i].y);
+    else
+      x_line(dev, x, y, pts[i].x, pts[i].y);
+    x = (mode == CoordModePrevious) ? x + pts[i].x : pts[i].x;
+    y = (mode == CoordModePrevious) ? y + pts[i].y : pts[i].y;
+   }
+}
+
+static void x_segments(dev, s, n)
+Device *dev;
+XSegment *s;
+int n;
+{
+  int i;
+
+  for (i=0; i<n; i++)
+    x_line(dev, s[i].x1, s[i].y1, s[i].x2, s[i].y2);
+}
+
+static void x_box(kind, color, x, y, width, height)
+int kind, color, x, y, width, height;
+{
+  Op *o = x_record(kind, color);
+
+  o->x = x;
+  o->y = y;
+  o->w = width;
+  o->h = height;
+}
+
+static void x_fill_rect(dev, color, x, y, width, height)
+Device *dev;
+int color, x, y, width, height;
+{
+  x_box(OP_FILL_RECT, color, x, y, width, height);
+}
+
+static void x_draw_rect(dev, x, y, width, height)
+Device *dev;
+int x, y, width, height;
+{
+  x_box(OP_DRAW_RECT, INK, x, y, width, height);
+}
+
+static void x_fill_arc(dev, color, x, y, width, height)
+Device *dev;
+int color, x, y, width, height;
+{
+  x_box(OP_FILL_ARC, color, x, y, width, height);
+}
+
+static void x_draw_arc(dev, x, y, width, height)
+Device *dev;
+int x, y, width, height;
+{
+  x_box(OP_DRAW_ARC, INK, x, y, width, height);
+}
+
+static void x_symbol(dev, sym, x, y)
+Device *dev;
+int sym, x, y;
+{
+  Op *o = x_record(OP_SYMBOL, INK);
+
+  o->sym = sym;
+  o->x = x;
+  o->y = y;
+}
+
+/*-- the string must stay put until the list is sent (they all live in
+     sec_world[] or title[]) --*/
+static void x_text(dev, x, y, str, len)
+Device *dev;
+int x, y, len;
+char *str;
+{
+  XFontStruct *f = x_font_at(cur_font);
+  XRectangle *r;
+  Op *o = x_record(OP_TEXT, INK);
+
+  o->x = x;
+  o->y = y;
+  o->str = str;
+  o->len = len;
+  if (x_mask != None) {
+    mask_rects = (XRectangle *) grow((char *) mask_rects, &mask_max,
+                mask_cnt, sizeof(XRectangle));
+    r = &mask_rects[mask_cnt++];
+    r->x = x;
+    r->y = y - f->ascent;
+    r->width = XTextWidth(f, str, len);
+    r->height = f->ascent + f->descent;
+   }
+}
+
+static void x_flush(dev)
+Device *dev;
+{
+  x_send();
+}
+
+static Device x_dev = { x_pen, x_font, x_width, x_line, x_lines, x_segments,
+                        x_fill_rect, x_draw_rect, x_fill_arc, x_draw_arc,
+                        x_symbol, x_text, x_flush, NULL };
+
+/*****************************************************************************
+ *                                                                           *
+ * Routines: x_device, x_layer_device, x_set_clip                            *
+ *                                                                           *
+ * Purpose:  Bind gen_sector() to an X drawable (the map window, a layer     *
+ *           pixmap or the PrintPix pixmap).  The pen and font state end up  *
+ *           in black_gc, PAPER fills use white_gc, exactly as before        *
+ *           gen_sector() drew through a Device.  x_layer_device() also sets *
+ *           the box of every string drawn in the depth 1 pixmap 'mask'      *
+ *           (cleared first), for layer.c to clip with; x_set_clip() clips   *
+ *           all of it to one rectangle, or to nothing if r is NULL.         *
+ *                                                                           *
+ *****************************************************************************/
+
+Device *x_device(d)
+Drawable d;
+{
+  x_send();
+  x_drawable = d;
+  x_mask = None;
+  return (&x_dev);
+}
+
+Device *x_layer_device(d, mask)
+Drawable d;
+Pixmap mask;
+{
+  (void) x_device(d);
+  if (mask_gc == NULL) {
+    mask_gc = XCreateGC(dpy, mask, 0, 0);
+    if (x_clip != NULL)
+      XSetClipRectangles(dpy, mask_gc, 0, 0, x_clip, 1, Unsorted);
+   }
+  XSetForeground(dpy, mask_gc, 0);
+  XFillRectangle(dpy, mask, mask_gc, 0, 0, MAP_WIDTH, MAP_HEIGHT);
+  XSetForeground(dpy, mask_gc, 1);
+  x_mask = mask;
+  return (&x_dev);
+}
+
+void x_set_clip(r)
+XRectangle *r;
+{
+  static XRectangle clip;
+
+  x_send();
+  x_clip = NULL;
+  if (r != NULL) {
+    clip = *r;
+    x_clip = &clip;
+    XSetClipRectangles(dpy, black_gc, 0, 0, x_clip, 1, Unsorted);
+    XSetClipRectangles(dpy, white_gc, 0, 0, x_clip, 1, Unsorted);
+    if (mask_gc != NULL)
+      XSetClipRectangles(dpy, mask_gc, 0, 0, x_clip, 1, Unsorted);
+   }
+  else {
+    XSetClipMask(dpy, black_gc, None);
+    XSetClipMask(dpy, white_gc, None);
+    if (mask_gc != NULL)
+      XSetClipMask(dpy, mask_gc, None);
+   }
+}
+
+/*-- font 'f' at the current scale: the misc-fixed font of that pixel size,
+     or 'f' itself if the server has none --*/
+static XFontStruct *x_scaled_font(f, bold)
+XFontStruct *f;
+int bold;
+{
+  XFontStruct *s;
+  char name[80];
+
+  sprintf(name, "-misc-fixed-%s-r-normal--%d-*-*-*-c-*-iso8859-1",
+                bold ? "bold" : "medium", S(f->ascent + f->descent));
+  if ((s = XLoadQueryFont(dpy, name)) == NULL)
+    return (f);
+  return (s);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Routine:  x_setup                                                         *
+ *                                                                           *
+ * Purpose:  Load the normal font and make the GCs and tile the X Device     *
+ *           draws with, for drawables of the default depth on the screen of *
+ *           'd'.  main() calls it once the display is open, as does the     *
+ *           bench driver.  Returns FALSE if the server has neither the      *
+ *           normal font nor "fixed".  The other fonts, the sizes of them    *
+ *           nearest the current scale (set_scale) and the base symbol atlas *
+ *           are made the first time the map uses them.  The panel keeps     *
+ *           fptr, at scale 1.                                               *
+ *                                                                           *
+ *****************************************************************************/
+
+int x_setup(d)
+Drawable d;
+{
+  int screen;
+  unsigned long black, white;
+  Pixmap chex;
+
+  if ((fptr = XLoadQueryFont(dpy, NORMAL_FONT)) == NULL) {
+    fprintf(stderr, "%s: Cannot open font \"%s\", using \"fixed\"\n",
+                program_name, NORMAL_FONT);
+    if ((fptr = XLoadQueryFont(dpy, "fixed")) == NULL)
+      return (FALSE);
+   }
+  x_root = d;
+
+  screen = DefaultScreen(dpy);
+  black = BlackPixel(dpy, screen);    white = WhitePixel(dpy, screen);
+
+  black_gc   = XCreateGC(dpy, d, 0, 0);
+  white_gc   = XCreateGC(dpy, d, 0, 0);
+
+  XSetFont(dpy, black_gc, fptr->fid);
+  XSetFont(dpy, white_gc, fptr->fid);
+
+  XSetForeground(dpy, black_gc, black);
+  XSetBackground(dpy, black_gc, white);
+  XSetForeground(dpy, white_gc, white);
+  XSetBackground(dpy, white_gc, black);
+
+  chex  = XCreatePixmapFromBitmapData(dpy, d, sm_chex_bits,
+                sm_chex_width, sm_chex_height, white, black, ScrDepth);
+
+  XSetTile(dpy, black_gc, chex);
+  XSetTile(dpy, white_gc, chex);
+  return (TRUE);
+}